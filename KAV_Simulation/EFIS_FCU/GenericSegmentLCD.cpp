@@ -0,0 +1,140 @@
+#include "GenericSegmentLCD.h"
+
+// segments a to g of each glyph, bit 0 = a
+static const uint8_t segmentsGeneric[GENERIC_SEGMENT_GLYPHS] PROGMEM = {
+    0b0111111, // 0
+    0b0000110, // 1
+    0b1011011, // 2
+    0b1001111, // 3
+    0b1100110, // 4
+    0b1101101, // 5
+    0b1111101, // 6
+    0b0000111, // 7
+    0b1111111, // 8
+    0b1101111, // 9
+    0b1000000, // -
+    0b0000000, // blank
+};
+#define GLYPH_DASH  10
+#define GLYPH_BLANK 11
+
+GenericSegmentLCD::GenericSegmentLCD(uint8_t CS, uint8_t CLK, uint8_t DATA)
+    : SegmentLCD(CS, CLK, DATA, &layout, false)
+{
+    layout.glyphs     = glyphs;
+    layout.glyphCount = GENERIC_SEGMENT_GLYPHS;
+    layout.blank      = GLYPH_BLANK;
+    layout.fields     = items;
+    // segment a to g on bit 0 to 6 until the wiring is defined
+    setWiring("0123456");
+}
+
+// builds the glyph table, 'bits' is the bit of the segments a to g within a digit, checked by addConfig()
+void GenericSegmentLCD::setWiring(const char *bits)
+{
+    uint8_t used = 0;
+
+    memset(glyphs, 0, sizeof(glyphs));
+    for (uint8_t segment = 0; segment < 7 && bits[segment]; segment++) {
+        uint8_t mask = 1 << ((bits[segment] - '0') & 0x07);
+        used |= mask;
+        for (uint8_t i = 0; i < GENERIC_SEGMENT_GLYPHS; i++) {
+            if (pgm_read_byte(&segmentsGeneric[i]) & (1 << segment))
+                glyphs[i] |= mask;
+        }
+    }
+    // all other bits are annunciators
+    layout.keepMask = ~used;
+}
+
+/* **********************************************************************************
+    The config string are "|" delimited tokens, each one is passed to addConfig():
+    S<a><b><c><d><e><f><g>  bit 0-7 of the segments a to g within a digit, e.g. S7650132
+    F<address>,<digits>     numeric field, address of the most significant digit (0-15)
+    A<address>,<bit>        annunciator, a single segment
+    Fields and annunciators get the messageIDs 0, 1, 2, ... in the order of the config.
+    Returns false if the token is not valid.
+********************************************************************************** */
+bool GenericSegmentLCD::addConfig(const char *token)
+{
+    char         *next;
+    unsigned long address, value; // not uint8_t, 263 must not pass as 7
+
+    if (token[0] == 'S') {
+        // exactly 7 different bits 0-7, otherwise two segments would be on the same bit
+        uint8_t used = 0;
+        for (uint8_t i = 1; i < 8; i++) {
+            if (token[i] < '0' || token[i] > '7' || (used & (1 << (token[i] - '0'))))
+                return false;
+            used |= 1 << (token[i] - '0');
+        }
+        if (token[8] != 0x00)
+            return false;
+        // annunciators which are already defined must not be on a segment bit
+        for (uint8_t i = 0; i < itemCount; i++) {
+            if (!items[i].digits && (used & (1 << (items[i].address & 0x07))))
+                return false;
+        }
+        setWiring(&token[1]);
+        return true;
+    }
+    if ((token[0] != 'F' && token[0] != 'A') || itemCount >= GENERIC_SEGMENT_ITEMS)
+        return false;
+
+    address = strtoul(&token[1], &next, 10);
+    if (*next != ',')
+        return false;
+    value = strtoul(next + 1, NULL, 10);
+
+    if (token[0] == 'F') {
+        if (value == 0 || address + value > BUFFER_SIZE_MAX)
+            return false;
+        items[itemCount].address = address;
+        items[itemCount].digits  = value;
+    } else {
+        // a segment bit is cleared by each value of the field, the annunciator would get out of sync
+        if (address >= BUFFER_SIZE_MAX || value > 7 || !(layout.keepMask & (1 << value)))
+            return false;
+        items[itemCount].address = SEGMENT(address, value);
+        items[itemCount].digits  = 0;
+    }
+    itemCount++;
+    return true;
+}
+
+// a negative value is shown with a '-' in the first digit
+void GenericSegmentLCD::showSignedValue(uint8_t field, int32_t value)
+{
+    if (value >= 0) {
+        showValue(field, value);
+        return;
+    }
+    displayDigit(items[field].address, GLYPH_DASH);
+    // negated as unsigned, -value would overflow for INT32_MIN
+    showNumber(items[field].address + 1, items[field].digits - 1, 0ul - (uint32_t)value);
+}
+
+void GenericSegmentLCD::set(int8_t messageID, char *setPoint)
+{
+    stage(messageID, setPoint);
+    ht.flush();
+}
+
+void GenericSegmentLCD::stage(int8_t messageID, char *setPoint)
+{
+    /* **********************************************************************************
+        MessageID == -1 and -2 clear the display, see KAV_A3XX_FCU_LCD::set()
+        All other messageIDs are the fields and annunciators in the order of the config
+    ********************************************************************************** */
+    if (messageID < 0) {
+        clearLCD();
+    } else if (messageID < itemCount) {
+        if (items[messageID].digits)
+            showSignedValue(messageID, atol(setPoint));
+        else
+            setSegment(items[messageID].address, atoi(setPoint) != 0);
+    }
+
+    // all functions above change only the buffer, copy the result once per message
+    stageLCD();
+}
@@ -0,0 +1,40 @@
+/**
+ * Generic segment LCD
+ * Drives any 7 segment LCD with an HT1621. The wiring of the segments, the numeric fields
+ * and the annunciators are defined by the config string, see addConfig().
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "SegmentLCD.h"
+
+// max. number of fields and annunciators, each one has its own messageID
+#define GENERIC_SEGMENT_ITEMS  16
+// glyphs of the generic display: 0-9, '-' and blank
+#define GENERIC_SEGMENT_GLYPHS 12
+
+class GenericSegmentLCD : public SegmentLCD
+{
+private:
+    // Fields
+    SegmentLayout layout;
+    uint8_t       glyphs[GENERIC_SEGMENT_GLYPHS];
+    // digits = 0 is an annunciator, its address is SEGMENT(address, bit)
+    SegmentField  items[GENERIC_SEGMENT_ITEMS];
+    uint8_t       itemCount = 0;
+
+    // Methods
+    void setWiring(const char *bits);
+    void showSignedValue(uint8_t field, int32_t value);
+
+public:
+    // Constructor
+    // 'CLK' is sometimes referred to as 'RW'
+    GenericSegmentLCD(uint8_t CS, uint8_t CLK, uint8_t DATA);
+
+    bool addConfig(const char *token);
+    void set(int8_t messageID, char *setPoint);
+    // like set(), but the changes are only written to the shadow RAM of the HT1621, flush() sends them
+    void stage(int8_t messageID, char *setPoint);
+};
@@ -16,41 +16,64 @@ void HT1621::begin()
     pinMode(_RW_pin, OUTPUT);
     pinMode(_CS_pin, OUTPUT);
 
-    digitalWrite(_CS_pin, HIGH);
-    digitalWrite(_RW_pin, HIGH);
-    digitalWrite(_DATA_pin, HIGH);
+    _cs.attach(_CS_pin);
+    _rw.attach(_RW_pin);
+    _data.attach(_DATA_pin);
+
+    _cs.high();
+    _rw.high();
+    _data.high();
 
-#ifndef __HT1621_READ
     for (uint8_t i = 0; i < MAX_ADDR; i++)
         ram[i] = 0;
-#endif
+    _dirty = 0;
+    resetStatistics();
 }
 
-// OCIO !!!
-// nell'esempio dopo ogni write viene dato un delay
-// di 20 microsecondi...
-void HT1621::writeBits(uint8_t data, uint8_t cnt)
+void HT1621::setTiming(TimingProfiles profile)
 {
-    for (uint8_t i = 0; i < cnt; i++, data <<= 1) {
-        digitalWrite(_RW_pin, LOW);
-        delayMicroseconds(20);
-        digitalWrite(_DATA_pin, data & 0x80 ? HIGH : LOW);
-        delayMicroseconds(20);
-        digitalWrite(_RW_pin, HIGH);
-        delayMicroseconds(20);
+    switch (profile) {
+    case TIMING_3V:
+        _clkLowUs  = 4;
+        _clkHighUs = 4;
+        break;
+    case TIMING_5V:
+        _clkLowUs  = 2;
+        _clkHighUs = 2;
+        break;
+    default:
+        _clkLowUs  = 40;
+        _clkHighUs = 20;
+        break;
     }
 }
 
-void HT1621::writeBitsReverse(uint32_t data, uint8_t cnt)
+// Data is latched on the rising edge of WR, so it is set up while WR is low.
+// The delays must cover the minimum WR clock width from the datasheet, see sec_timing.
+inline void HT1621::writeBit(bool bit)
 {
-    for (uint8_t i = 0; i < cnt; i++, data >>= 1) {
-        digitalWrite(_RW_pin, LOW);
-        delayMicroseconds(20);
-        digitalWrite(_DATA_pin, data & 1 ? HIGH : LOW);
-        delayMicroseconds(20);
-        digitalWrite(_RW_pin, HIGH);
-        delayMicroseconds(20);
+    if (_writeBitFunction) {
+        _writeBitFunction(bit, _clkLowUs, _clkHighUs);
+    } else {
+        _rw.low();
+        _data.write(bit);
+        delayMicroseconds(_clkLowUs);
+        _rw.high();
+        delayMicroseconds(_clkHighUs);
     }
+    _bitsSent++;
+}
+
+void HT1621::writeBits(uint8_t data, uint8_t cnt)
+{
+    for (uint8_t i = 0; i < cnt; i++, data <<= 1)
+        writeBit(data & 0x80);
+}
+
+void HT1621::writeBitsReverse(uint32_t data, uint8_t cnt)
+{
+    for (uint8_t i = 0; i < cnt; i++, data >>= 1)
+        writeBit(data & 1);
 }
 
 #ifdef __HT1621_READ
@@ -78,10 +101,13 @@ uint8_t HT1621::readBits(uint8_t cnt)
 void HT1621::sendCommand(uint8_t cmd, bool first, bool last)
 {
     if (first) {
+        completeFrame();
         TAKE_CS();
-        writeBits(COMMAND_MODE, 4);
+        writeBits(COMMAND_MODE, 3);
     }
 
+    // each command has 9 bits, the first one is always 0, also for the following commands in the same frame
+    writeBits(0, 1);
     writeBits(cmd, 8);
 
     if (last)
@@ -90,34 +116,274 @@ void HT1621::sendCommand(uint8_t cmd, bool first, bool last)
 
 void HT1621::write(uint8_t address, uint32_t bits, uint8_t bit_cnt)
 {
+    completeFrame();
     TAKE_CS();
 
     writeBits(WRITE_MODE, 3);
     writeBits(address << 2, 6); // send only 6 bit, starting from more significant
     writeBitsReverse(bits, bit_cnt);
-#ifndef __HT1621_READ
-    // ram[address] = bits; // TODO
-#endif
 
     RELEASE_CS();
+
+    // the address is incremented by the HT1621 after each 4 bits
+    for (uint8_t i = 0; i < bit_cnt; i += 4, bits >>= 4, address++) {
+        address &= MAX_ADDR - 1;
+        ram[address] = bits & 0x0F;
+        _dirty &= ~(1ul << address);
+    }
 }
 
 void HT1621::writeArray(uint8_t address, uint8_t *array, uint8_t cnt)
 {
+    completeFrame();
     TAKE_CS();
 
     writeBits(WRITE_MODE, 3);
     writeBits(address << 2, 6);
     for (uint8_t i = 0; i < cnt; i++) {
         writeBitsReverse(array[i], 4);
-#ifndef __HT1621_READ
-        ram[i] = array[i];
-#endif
+        ram[(address + i) & (MAX_ADDR - 1)] = array[i] & 0x0F;
+        _dirty &= ~(1ul << ((address + i) & (MAX_ADDR - 1)));
     }
 
     RELEASE_CS();
 }
 
+void HT1621::bufferedWrite(uint8_t address, uint32_t bits, uint8_t bit_cnt)
+{
+    for (uint8_t i = 0; i < bit_cnt; i += 4, bits >>= 4, address++) {
+        address &= MAX_ADDR - 1;
+        if (ram[address] != (bits & 0x0F)) {
+            ram[address] = bits & 0x0F;
+            _dirty |= 1ul << address;
+        }
+    }
+}
+
+// Finds the first run of dirty addresses which is sent within one frame
+bool HT1621::nextRun(uint32_t dirty, uint8_t &first, uint8_t &last)
+{
+    if (!dirty)
+        return false;
+
+    first = 0;
+    while (!(dirty & (1ul << first)))
+        first++;
+
+    // extend the frame up to the last dirty address which is not separated by too many clean ones
+    last = first;
+    for (uint8_t next = first + 1; next < MAX_ADDR && next - last <= FLUSH_MAX_GAP + 1; next++) {
+        if (dirty & (1ul << next))
+            last = next;
+    }
+    return true;
+}
+
+void HT1621::flush()
+{
+    uint8_t first, last;
+
+    if (_async)
+        return;
+    completeFrame();
+
+    while (nextRun(_dirty, first, last)) {
+        TAKE_CS();
+        writeBits(WRITE_MODE, 3);
+        writeBits(first << 2, 6);
+        for (; first <= last; first++) {
+            writeBitsReverse(ram[first], 4);
+            _dirty &= ~(1ul << first);
+        }
+        RELEASE_CS();
+    }
+}
+
+void HT1621::flush(HT1621 *chips[], uint8_t count)
+{
+    Lanes    lanes;
+    uint32_t dirty = 0;
+    uint8_t  first, last;
+
+    lanes.chips     = chips;
+    lanes.count     = count;
+    lanes.clkLowUs  = 0;
+    lanes.clkHighUs = 0;
+#if defined(HT1621_PINIO_AVR)
+    lanes.port    = chips[0]->_data._port;
+    lanes.in      = chips[0]->_data._in;
+    lanes.guarded = chips[0]->_data._guarded;
+#endif
+    lanes.all = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        // without a shared WR or in asynchronous mode each chip is written on its own
+        if (count > HT1621_MAX_LANES || chips[i]->_RW_pin != chips[0]->_RW_pin || chips[i]->_async) {
+            for (i = 0; i < count; i++)
+                chips[i]->flush();
+            return;
+        }
+        chips[i]->completeFrame();
+        dirty |= chips[i]->_dirty;
+        // the slowest timing profile is used for all chips
+        lanes.clkLowUs  = max(lanes.clkLowUs, chips[i]->_clkLowUs);
+        lanes.clkHighUs = max(lanes.clkHighUs, chips[i]->_clkHighUs);
+#if defined(HT1621_PINIO_AVR)
+        if (chips[i]->_data._port != lanes.port)
+            lanes.port = nullptr;
+        lanes.all |= chips[i]->_data._mask;
+#elif defined(HT1621_PINIO_RP2040)
+        lanes.all |= chips[i]->_data._mask;
+#endif
+    }
+
+    while (nextRun(dirty, first, last)) {
+        // all addresses of the frame, a chip is only selected if one of them is dirty for this chip
+        uint32_t run      = (0xFFFFFFFFul << first) & (0xFFFFFFFFul >> (MAX_ADDR - 1 - last));
+        uint8_t  selected = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (chips[i]->_dirty & run) {
+                selected |= 1 << i;
+                chips[i]->_dirty &= ~run;
+                chips[i]->_bitsSent += 9 + 4 * (last - first + 1);
+                chips[i]->_framesSent++;
+                chips[i]->_cs.low();
+            }
+        }
+        // same bit order as flush(): 3 bit mode and 6 bit address MSB first, then the nibbles LSB first
+        for (uint8_t bit = 0; bit < 3; bit++)
+            lanes.writeBit(((WRITE_MODE << bit) & 0x80) ? 0xFF : 0x00);
+        for (uint8_t bit = 0; bit < 6; bit++)
+            lanes.writeBit((((first << 2) << bit) & 0x80) ? 0xFF : 0x00);
+        for (uint8_t address = first; address <= last; address++) {
+            for (uint8_t bit = 0; bit < 4; bit++) {
+                uint8_t bits = 0;
+                for (uint8_t i = 0; i < count; i++)
+                    bits |= ((chips[i]->ram[address] >> bit) & 0x01) << i;
+                lanes.writeBit(bits);
+            }
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            if (selected & (1 << i))
+                chips[i]->_cs.high();
+        }
+        dirty &= ~run;
+    }
+}
+
+// Sets the DATA pin of each chip to its bit of 'bits' and clocks all chips with the shared WR
+inline void HT1621::Lanes::writeBit(uint8_t bits)
+{
+    chips[0]->_rw.low();
+#if defined(HT1621_PINIO_AVR)
+    if (port) {
+        // all DATA pins change with one port write
+        uint8_t set = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (bits & (1 << i))
+                set |= chips[i]->_data._mask;
+        }
+        if (guarded) {
+            uint8_t oldSREG = SREG;
+            cli();
+            *port = (*port & ~all) | set;
+            SREG  = oldSREG;
+        } else {
+            *in = (*port ^ set) & all; // toggles the DATA pins which have to change
+        }
+    } else {
+        for (uint8_t i = 0; i < count; i++)
+            chips[i]->_data.write(bits & (1 << i));
+    }
+#elif defined(HT1621_PINIO_RP2040)
+    uint32_t set = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (bits & (1 << i))
+            set |= chips[i]->_data._mask;
+    }
+    sio_hw->gpio_set = set;
+    sio_hw->gpio_clr = all & ~set;
+#else
+    for (uint8_t i = 0; i < count; i++)
+        chips[i]->_data.write(bits & (1 << i));
+#endif
+    delayMicroseconds(clkLowUs);
+    chips[0]->_rw.high();
+    delayMicroseconds(clkHighUs);
+}
+
+void HT1621::invalidate()
+{
+    _dirty = 0xFFFFFFFF;
+}
+
+void HT1621::setAsync(bool enabled)
+{
+    completeFrame();
+    _async = enabled;
+}
+
+bool HT1621::update(uint8_t maxBits)
+{
+    while (maxBits) {
+        if (!_txActive) {
+            if (!_async || !nextRun(_dirty, _txFirst, _txLast))
+                break;
+            // addresses changed while the frame is sent get dirty again and are sent with the next frame
+            for (uint8_t i = _txFirst; i <= _txLast; i++)
+                _dirty &= ~(1ul << i);
+            _txPos    = 0;
+            _txActive = true;
+            TAKE_CS();
+        }
+
+        // same bit order as flush(): 3 bit mode and 6 bit address MSB first, then the nibbles LSB first
+        uint8_t frameBits = 9 + 4 * (_txLast - _txFirst + 1);
+        for (; maxBits && _txPos < frameBits; maxBits--, _txPos++) {
+            if (_txPos < 3)
+                writeBit((WRITE_MODE << _txPos) & 0x80);
+            else if (_txPos < 9)
+                writeBit(((_txFirst << 2) << (_txPos - 3)) & 0x80);
+            else
+                writeBit((ram[_txFirst + ((_txPos - 9) >> 2)] >> ((_txPos - 9) & 0x03)) & 0x01);
+        }
+
+        if (_txPos == frameBits) {
+            RELEASE_CS();
+            _txActive = false;
+        }
+    }
+    return _txActive || (_async && _dirty);
+}
+
+// Sends the remaining bits of a frame started by update(), so CS can be used for a new frame
+void HT1621::completeFrame()
+{
+    if (_txActive)
+        update(9 + 4 * (_txLast - _txFirst + 1) - _txPos);
+}
+
+uint32_t HT1621::getBitsSent()
+{
+    return _bitsSent;
+}
+
+uint16_t HT1621::getFramesSent()
+{
+    return _framesSent;
+}
+
+uint32_t HT1621::getBusTime()
+{
+    return _bitsSent * (_clkLowUs + _clkHighUs);
+}
+
+void HT1621::resetStatistics()
+{
+    _bitsSent   = 0;
+    _framesSent = 0;
+}
+
 #ifdef __HT1621_READ
 
 uint8_t HT1621::read(uint8_t address)
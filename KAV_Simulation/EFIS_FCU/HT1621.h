@@ -45,13 +45,98 @@
  * - Bias/com configuration
  * - Bias generator start (LCD_ON)
  *
+ * \section sec_timing Bus timing
+ * Data is latched by the HT1621 on the rising edge of WR. The datasheet requires a WR clock width of at
+ * least 3.34us at VDD = 3V and 1.67us at VDD = 5V, data setup and hold times are 120ns. The delays used while
+ * writing are selected by one of the \c TimingProfiles, see HT1621::setTiming(). The default profile depends
+ * on the board and can be overwritten by defining \c HT1621_DEFAULT_TIMING.
+ *
+ * Bus time for one 8 bit write as done by the KAV displays (3 bit mode + 6 bit address + 8 bit data = 17 clocks).
+ * These numbers are calculated from the clock widths, they were not measured on hardware and the pin toggling
+ * overhead is not included:
+ * Profile        | Clock low/high | us per clock | us per 8 bit write
+ * -------------- | -------------- | ------------ | ------------------
+ * TIMING_LEGACY  | 40us / 20us    | 60           | 1020
+ * TIMING_3V      | 4us / 4us      | 8            | 136
+ * TIMING_5V      | 2us / 2us      | 4            | 68
+ *
+ * \section sec_pinio Pin IO
+ * The pins are not toggled by \c digitalWrite() if a faster backend is available. On AVR the port registers
+ * are written directly, on RP2040 the SIO set/clear registers are used. All other boards use \c digitalWrite().
+ * The port of an AVR pin is only known at runtime, so the compiler cannot use \c sbi and \c cbi. On the ports A
+ * to G a pin is changed by writing its bit to \c PINx, which toggles only this bit with one store, no other bit
+ * of the port can be lost if an interrupt changes it at the same time. The ports H to L of the Mega have no
+ * single instruction access, their read-modify-write runs with interrupts disabled.
+ * The time per write including the overhead of each backend is measured on a board by the benchmark
+ * \c test_bench_ht1621 of the host build in \c _test, e.g. with \c pio \c test \c -e \c bench_mega.
+ * Define \c HT1621_USE_DIGITALWRITE to force the \c digitalWrite() backend.
+ *
+ * \section sec_stats Bus statistics
+ * Each bit and each frame (CS taken) written to the HT1621 is counted, see getBitsSent() and getFramesSent().
+ * getBusTime() calculates the bus time of these bits from the clock widths of the current timing profile, so
+ * the cost of a change can be compared between timing profiles, buffered and direct writes. Pin toggling
+ * overhead is not included, like in the table above.
+ * The counters only measure the bus load. What the frames write to the display RAM and whether they keep the
+ * datasheet timing (\c MIN_CLK_WIDTH_3V_NS and the other minimums) is checked by the decoder of the host build,
+ * see \ref sec_host.
+ *
+ * \section sec_host Builds without a board
+ * If neither \c ARDUINO_ARCH_AVR nor \c ARDUINO_ARCH_RP2040 is defined, only \c pinMode(), \c digitalWrite() and
+ * \c delayMicroseconds() from \c Arduino.h are used, \c ARDUINO must be defined to 100 or higher. The host build
+ * in \c _test uses this, its \c Arduino.h logs every pin change with a simulated time. \c HT1621Decoder of the
+ * host build decodes the CS, WR and DATA pins into the command state and the 32 nibbles of the display RAM, measures
+ * the bus time of each frame and counts WR clocks and data changes which are shorter than the timing model above.
+ *
+ * \section sec_shadow Shadow RAM
+ * A copy of the HT1621 RAM is kept in the class. bufferedWrite() only changes this copy and marks the changed
+ * addresses as dirty, flush() sends them. Contiguous dirty addresses are sent as one successive address write,
+ * so only one mode and address header is required for them. Clean gaps of up to \c FLUSH_MAX_GAP addresses
+ * are sent along, as 4 bits per address are cheaper than a new frame with 9 header bits.
+ *
+ * \section sec_fixed Fixed pins
+ * If the wiring is known at compile time, HT1621Fixed<CS, RW, DATA> from HT1621Fixed.h can be used instead of
+ * HT1621. It is derived from HT1621 and has the same interface, WR and DATA are written by a function which is
+ * compiled for these pins. On the Mega and the Uno/Nano each edge on the ports A to G is a single \c sbi or
+ * \c cbi instruction, on RP2040 a store of a constant mask to the SIO set/clear register. On other boards the
+ * runtime pins of \ref sec_pinio are used. The bus time of the timing profile stays the same, only the time
+ * between the delays changes. \c test_bench_ht1621 of the host build compares both versions on a board.
+ * The parallel flush() of several HT1621 uses the runtime pins for all chips.
+ *
+ * \section sec_lanes Parallel lanes
+ * Several HT1621 can share the WR pin if each one has its own CS and DATA pin. The static flush() sends the dirty
+ * addresses of all of them in the same frames: every chip with a dirty address in the frame is selected by its CS,
+ * each clock writes the next bit of all selected chips. Clean addresses within a frame are sent again from the
+ * shadow RAM. If the DATA pins are on the same AVR port, all of them are changed with one port write, on RP2040
+ * the SIO set/clear registers change them at once, otherwise they are written one after the other before the
+ * clock. Writing three displays takes the time of the longest one instead of the sum of all.
+ * If the WR pins differ, flush() of each HT1621 is called one after the other, the displays are written correctly
+ * but without the gain.
+ *
+ * \section sec_async Asynchronous mode
+ * In asynchronous mode flush() returns immediately and the dirty addresses are sent step by step by update(),
+ * which has to be called regularly. Each call sends at most \c HT1621_ASYNC_BITS_PER_UPDATE bits, so the
+ * caller is never blocked for longer than this number of clocks. The dirty bitmap is the transmit queue,
+ * so several changes of the same address before it is sent result in one transfer of the latest value.
+ * Define \c HT1621_ASYNC to enable asynchronous mode by default, or use setAsync().
+ * All other functions which access the bus complete a pending frame before.
+ * The frames are split only in time, the bits and the clock widths are the same as with a synchronous flush(),
+ * this is checked by \c test_ht1621_async of the host build for several split sizes.
+ *
  * \section sec_history History
  * \subsection subsec_v1_0 Version 1.0
  * This the first public version.
+ * \subsection subsec_v1_1 Version 1.1
+ * Direct port access for AVR and RP2040, timing profiles instead of fixed 20us delays.
+ * Shadow RAM with dirty tracking, bufferedWrite() and flush().
+ * Asynchronous mode, setAsync() and update().
+ * Bus statistics.
+ * Parallel lanes for HT1621 with a shared WR pin.
+ * Several commands in one frame are sent with 9 bits each like the first one.
+ * HT1621Fixed with pins known at compile time.
  *
  * \section sec_todo Todo list
  * - Improve the overall documentation.
- * - Optimize delays in both writing and reading functions
+ * - Optimize delays in reading functions
  * - Overload \c HT1621::sendCommand() function to send several commands in a row
  * - Test reading functions which use the internal RAM of HT1621 not the simulated RAM.
  */
@@ -77,8 +162,37 @@
 
 #endif
 
-#define TAKE_CS()    digitalWrite(_CS_pin, LOW)
-#define RELEASE_CS() digitalWrite(_CS_pin, HIGH)
+#if !defined(HT1621_USE_DIGITALWRITE)
+#if defined(ARDUINO_ARCH_AVR)
+#define HT1621_PINIO_AVR
+// last data address of the ports which sbi/cbi can access, PORTA to PORTG, the ports of the Mega above are guarded
+#define HT1621_AVR_BIT_IO_END 0x3F
+#elif defined(ARDUINO_ARCH_RP2040)
+#define HT1621_PINIO_RP2040
+#include <hardware/structs/sio.h>
+#endif
+#endif
+
+#ifndef HT1621_DEFAULT_TIMING
+#if defined(ARDUINO_ARCH_AVR)
+#define HT1621_DEFAULT_TIMING HT1621::TIMING_5V
+#elif defined(ARDUINO_ARCH_RP2040)
+#define HT1621_DEFAULT_TIMING HT1621::TIMING_3V
+#else
+#define HT1621_DEFAULT_TIMING HT1621::TIMING_LEGACY
+#endif
+#endif
+
+#ifndef HT1621_ASYNC_BITS_PER_UPDATE
+#define HT1621_ASYNC_BITS_PER_UPDATE 16
+#endif
+
+#ifndef HT1621_MAX_LANES
+#define HT1621_MAX_LANES 8
+#endif
+
+#define TAKE_CS()    (_framesSent++, _cs.low())
+#define RELEASE_CS() _cs.high()
 
 // Uncomment the line below if you can read from the HT1621 directly
 // #define __HT1621_READ
@@ -148,7 +262,26 @@ public:
         TEST_OFF = 0b11000110  /*!< Don't use! Only for manifacturers. This needs SPECIAL_MODE. */
     };
 
-    static const uint8_t MAX_ADDR = 32;
+    /*!
+     * Timing profiles for the serial interface. \sa setTiming()
+     */
+    enum TimingProfiles : uint8_t {
+        TIMING_LEGACY, /*!< 40us clock low, 20us clock high. This is the timing of the original library. */
+        TIMING_3V,     /*!< 4us clock low and high. Datasheet minimum at VDD = 3V is 3.34us. */
+        TIMING_5V      /*!< 2us clock low and high. Datasheet minimum at VDD = 5V is 1.67us. */
+    };
+
+    static const uint8_t MAX_ADDR      = 32;
+    static const uint8_t FLUSH_MAX_GAP = 2;
+
+    /* **********************************************************************************
+        Timing model of the serial interface, minimum times from the datasheet in ns.
+        The clock width applies to WR low and WR high. \sa sec_timing
+    ********************************************************************************** */
+    static const uint16_t MIN_CLK_WIDTH_3V_NS = 3340;
+    static const uint16_t MIN_CLK_WIDTH_5V_NS = 1670;
+    static const uint16_t MIN_DATA_SETUP_NS   = 120;
+    static const uint16_t MIN_DATA_HOLD_NS    = 120;
     /**
      * \brief Constructor. Use begin() to complete the initialization of the chip.
      * @param \c CSpin Channel select pin.
@@ -156,13 +289,25 @@ public:
      * @param \c DATApin Data pin both for reading or writing data.
      */
     HT1621(uint8_t CSpin, uint8_t RWpin, uint8_t DATApin)
-        : _CS_pin(CSpin), _DATA_pin(DATApin), _RW_pin(RWpin){};
+        : _CS_pin(CSpin), _DATA_pin(DATApin), _RW_pin(RWpin)
+    {
+        setTiming(HT1621_DEFAULT_TIMING);
+#ifdef HT1621_ASYNC
+        _async = true;
+#endif
+    };
 
     /**
      *  \brief Init the HT1621. It inits the control bus. Moreover, it clears the (simulated) ram if \c __HT1621_READ is defined.
      */
     void begin();
 
+    /**
+     * \brief Select the delays used for each bit written to the HT1621.
+     * @param profile One of the \c TimingProfiles.
+     */
+    void setTiming(TimingProfiles profile);
+
     /**
      * \brief Send bits to the HT1621.
      * @param data Data to be sent to the HT1621 seen as an array of bits.
@@ -191,6 +336,7 @@ public:
      * @param cmd Id of the command to send.
      * @param first If true CS is taken.
      * @param last  If true CS is released.
+     * Several commands can be sent in one frame, e.g. sendCommand(SYS_EN, true, false) and sendCommand(LCD_ON, false, true).
      * \warning There is no check on the command id.
      */
     void sendCommand(uint8_t cmd, bool first = true, bool last = true);
@@ -215,6 +361,51 @@ public:
      */
     void writeArray(uint8_t address, uint8_t *array, uint8_t cnt);
 
+    /**
+     * \brief Write \c bits at the given address into the shadow RAM only. Use flush() to send them.
+     * @param address Address to which write the bits. Max address is 31.
+     * @param bits Contains bits to be written.
+     * @param bit_cnt Count of bits to write starting from less significant, must be a multiple of 4.
+     * \remark Only addresses whose content changes are marked as dirty.
+     * \sa sec_shadow
+     */
+    void bufferedWrite(uint8_t address, uint32_t bits, uint8_t bit_cnt = 4);
+
+    /**
+     * \brief Send all dirty addresses of the shadow RAM to the HT1621.
+     * \sa sec_shadow
+     */
+    void flush();
+
+    /**
+     * \brief Send all dirty addresses of several HT1621 which share the WR pin at once.
+     * @param chips Array of the HT1621, all must use the same WR pin and a separate CS and DATA pin.
+     * @param count Number of HT1621 in the array, max. \c HT1621_MAX_LANES.
+     * \remark If the WR pins differ or one of the HT1621 is in asynchronous mode, flush() of each HT1621 is called.
+     * \sa sec_lanes
+     */
+    static void flush(HT1621 *chips[], uint8_t count);
+
+    /**
+     * \brief Mark the complete shadow RAM as dirty, so the next flush() sends all addresses.
+     */
+    void invalidate();
+
+    /**
+     * \brief Select if flush() sends the dirty addresses or if update() sends them step by step.
+     * @param enabled If true, asynchronous mode is used.
+     * \sa sec_async
+     */
+    void setAsync(bool enabled);
+
+    /**
+     * \brief Send the next bits of the dirty addresses in asynchronous mode.
+     * @param maxBits Maximum number of bits to send.
+     * \return bool True if there are still bits to send.
+     * \sa sec_async
+     */
+    bool update(uint8_t maxBits = HT1621_ASYNC_BITS_PER_UPDATE);
+
     /**
      * \brief Read memory content at address \c address
      * @param address Memory address to read from (maximum is 31).
@@ -223,6 +414,26 @@ public:
      */
     uint8_t read(uint8_t address);
 
+    /**
+     * \brief Number of bits written to the HT1621 since begin() or resetStatistics(). \sa sec_stats
+     */
+    uint32_t getBitsSent();
+
+    /**
+     * \brief Number of frames (CS taken) since begin() or resetStatistics(). \sa sec_stats
+     */
+    uint16_t getFramesSent();
+
+    /**
+     * \brief Bus time in us of all bits sent, calculated from the clock widths of the timing profile. \sa sec_stats
+     */
+    uint32_t getBusTime();
+
+    /**
+     * \brief Clear the bus statistics.
+     */
+    void resetStatistics();
+
     /**
      * \brief Read \c cnt 4-bit values starting from \c address into buffer \c data.
      * @param address Memory address to read from (maximum is 31).
@@ -233,19 +444,147 @@ public:
      */
     void read(uint8_t address, uint8_t *data, uint8_t cnt);
 
+protected:
+    /**
+     * Writes one bit with WR and DATA pins which are known at compile time. \sa HT1621Fixed
+     */
+    typedef void (*WriteBitFunction)(bool bit, uint8_t clkLowUs, uint8_t clkHighUs);
+
+    WriteBitFunction _writeBitFunction = nullptr;
+
 private:
-    uint8_t _CS_pin;
-    uint8_t _DATA_pin;
-    uint8_t _RW_pin;
+    /**
+     * Output pin which is toggled by the fastest way available on the board. \sa sec_pinio
+     */
+    class PinIO
+    {
+        friend class HT1621;
+
+    public:
+        void attach(uint8_t pin)
+        {
+#if defined(HT1621_PINIO_AVR)
+            _port    = portOutputRegister(digitalPinToPort(pin));
+            _in      = portInputRegister(digitalPinToPort(pin));
+            _mask    = digitalPinToBitMask(pin);
+            _guarded = (uintptr_t)_port > HT1621_AVR_BIT_IO_END;
+#elif defined(HT1621_PINIO_RP2040)
+            _mask = 1ul << pin;
+#else
+            _pin = pin;
+#endif
+        }
+
+        inline void high()
+        {
+#if defined(HT1621_PINIO_AVR)
+            if (_guarded) {
+                uint8_t oldSREG = SREG; // ports above G are not bit addressable, so protect read-modify-write
+                cli();
+                *_port |= _mask;
+                SREG = oldSREG;
+            } else if (!(*_port & _mask)) {
+                *_in = _mask; // writing a 1 to PINx toggles only this bit of PORTx
+            }
+#elif defined(HT1621_PINIO_RP2040)
+            sio_hw->gpio_set = _mask;
+#else
+            digitalWrite(_pin, HIGH);
+#endif
+        }
+
+        inline void low()
+        {
+#if defined(HT1621_PINIO_AVR)
+            if (_guarded) {
+                uint8_t oldSREG = SREG;
+                cli();
+                *_port &= ~_mask;
+                SREG = oldSREG;
+            } else if (*_port & _mask) {
+                *_in = _mask;
+            }
+#elif defined(HT1621_PINIO_RP2040)
+            sio_hw->gpio_clr = _mask;
+#else
+            digitalWrite(_pin, LOW);
+#endif
+        }
+
+        inline void write(bool state)
+        {
+            if (state)
+                high();
+            else
+                low();
+        }
+
+    private:
+#if defined(HT1621_PINIO_AVR)
+        volatile uint8_t *_port;
+        volatile uint8_t *_in;
+        uint8_t           _mask;
+        bool              _guarded; // port H to L of the Mega
+#elif defined(HT1621_PINIO_RP2040)
+        uint32_t _mask;
+#else
+        uint8_t _pin;
+#endif
+    };
+
+    uint8_t  _CS_pin;
+    uint8_t  _DATA_pin;
+    uint8_t  _RW_pin;
+    PinIO    _cs;
+    PinIO    _rw;
+    PinIO    _data;
+    uint8_t  _clkLowUs;
+    uint8_t  _clkHighUs;
+    bool     _async    = false;
+    bool     _txActive = false; // a frame is started by update() and CS is taken
+    uint8_t  _txFirst;          // first and last address of this frame
+    uint8_t  _txLast;
+    uint8_t  _txPos;            // number of bits sent in this frame
+    uint32_t _bitsSent   = 0;
+    uint16_t _framesSent = 0;
 
-#ifndef __HT1621_READ
     /**
-     * This array is used to simulate the HT1621 internal ram whenever the read operations are not possible.
-     * \warning Define the label __HT1621 to disable this feature and use standard read procedures.
+     * The DATA pins of HT1621 which share the WR pin, one bit per chip is written with each clock. \sa sec_lanes
+     */
+    struct Lanes {
+        HT1621 **chips;
+        uint8_t  count;
+        uint8_t  clkLowUs;
+        uint8_t  clkHighUs;
+#if defined(HT1621_PINIO_AVR)
+        volatile uint8_t *port; // nullptr if the DATA pins are not on the same port
+        volatile uint8_t *in;
+        bool              guarded;
+        uint8_t           all;
+#elif defined(HT1621_PINIO_RP2040)
+        uint32_t all;
+#else
+        uint8_t all;
+#endif
+
+        inline void writeBit(uint8_t bits);
+    };
+
+    inline void writeBit(bool bit);
+    static bool nextRun(uint32_t dirty, uint8_t &first, uint8_t &last);
+    void        completeFrame();
+
+    /**
+     * This array is the shadow of the HT1621 internal ram. It is also used to simulate read operations
+     * whenever they are not possible.
+     * \warning Define the label __HT1621_READ to use standard read procedures.
      * Only low 4 bits in each element are meaningful.
      */
     uint8_t ram[MAX_ADDR];
-#endif
+    /**
+     * One bit per address of the shadow RAM which is not yet sent to the HT1621.
+     */
+    uint32_t _dirty;
 };
 
 #endif
@@ -0,0 +1,157 @@
+/**
+ * \file HT1621Fixed.h
+ * \brief HT1621 with the pins known at compile time.
+ *
+ * HT1621Fixed<CS, RW, DATA> behaves like HT1621(CS, RW, DATA), but WR and DATA are toggled by a function
+ * which is compiled for these pins. See \ref sec_fixed.
+ */
+
+#pragma once
+
+#include "HT1621.h"
+
+#if defined(HT1621_PINIO_AVR) && (defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__))
+
+/* **********************************************************************************
+    Data space address of the PORT register and the bit of each pin of the Arduino Mega,
+    same as digital_pin_to_port_PGM[] and digital_pin_to_bit_mask_PGM[] of the mega variant.
+    PORTA to PORTG are below 0x40, so they can be set and cleared by sbi/cbi.
+********************************************************************************** */
+#define HT1621_FIXED_AVR
+namespace HT1621FixedPins
+{
+    constexpr uint16_t A = 0x22, B = 0x25, C = 0x28, D = 0x2B, E = 0x2E, F = 0x31, G = 0x34;
+    constexpr uint16_t H = 0x102, J = 0x105, K = 0x108, L = 0x10B;
+
+    constexpr uint8_t  PINS       = 70;
+    constexpr uint16_t port[PINS] = {
+        E, E, E, E, G, E, H, H, H, H, // 0-9
+        B, B, B, B, J, J, H, H, D, D, // 10-19
+        D, D, A, A, A, A, A, A, A, A, // 20-29
+        C, C, C, C, C, C, C, C, D, G, // 30-39
+        G, G, L, L, L, L, L, L, L, L, // 40-49
+        B, B, B, B, F, F, F, F, F, F, // 50-59
+        F, F, K, K, K, K, K, K, K, K  // 60-69
+    };
+    constexpr uint8_t bit[PINS] = {
+        0, 1, 4, 5, 5, 3, 3, 4, 5, 6, // 0-9
+        4, 5, 6, 7, 1, 0, 1, 0, 3, 2, // 10-19
+        1, 0, 0, 1, 2, 3, 4, 5, 6, 7, // 20-29
+        7, 6, 5, 4, 3, 2, 1, 0, 7, 2, // 30-39
+        1, 0, 7, 6, 5, 4, 3, 2, 1, 0, // 40-49
+        3, 2, 1, 0, 0, 1, 2, 3, 4, 5, // 50-59
+        6, 7, 0, 1, 2, 3, 4, 5, 6, 7  // 60-69
+    };
+}
+
+#elif defined(HT1621_PINIO_AVR) && (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__))
+
+// the same for the Uno and the Nano, pins 0-7 are PORTD, 8-13 PORTB and 14-19 (A0-A5) PORTC
+#define HT1621_FIXED_AVR
+namespace HT1621FixedPins
+{
+    constexpr uint16_t B = 0x25, C = 0x28, D = 0x2B;
+
+    constexpr uint8_t  PINS       = 20;
+    constexpr uint16_t port[PINS] = {D, D, D, D, D, D, D, D, B, B, B, B, B, B, C, C, C, C, C, C};
+    constexpr uint8_t  bit[PINS]  = {0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5};
+}
+
+#endif
+
+/**
+ * Output pin known at compile time. On the Mega and the Uno/Nano the port register and bit are taken from the
+ * tables above, on RP2040 the SIO set/clear registers are used. With the \c digitalWrite() backend of HT1621
+ * \c digitalWrite() is used as well. Other AVR boards have no table, HT1621Fixed uses the runtime pins there.
+ */
+template <uint8_t PIN>
+class HT1621FixedPin;
+
+#if defined(HT1621_FIXED_AVR)
+
+#define HT1621_FIXED_PINIO
+template <uint8_t PIN>
+class HT1621FixedPin
+{
+    static_assert(PIN < HT1621FixedPins::PINS, "pin does not exist on this board");
+    static constexpr uint16_t PORT = HT1621FixedPins::port[PIN];
+    static constexpr uint8_t  MASK = 1 << HT1621FixedPins::bit[PIN];
+
+public:
+    static inline void high()
+    {
+        if (PORT <= HT1621_AVR_BIT_IO_END) {
+            *(volatile uint8_t *)PORT |= MASK; // sbi
+        } else {
+            uint8_t oldSREG = SREG; // ports above G are not bit addressable, so protect read-modify-write
+            cli();
+            *(volatile uint8_t *)PORT |= MASK;
+            SREG = oldSREG;
+        }
+    }
+
+    static inline void low()
+    {
+        if (PORT <= HT1621_AVR_BIT_IO_END) {
+            *(volatile uint8_t *)PORT &= ~MASK; // cbi
+        } else {
+            uint8_t oldSREG = SREG;
+            cli();
+            *(volatile uint8_t *)PORT &= ~MASK;
+            SREG = oldSREG;
+        }
+    }
+};
+
+#elif defined(HT1621_PINIO_RP2040)
+
+#define HT1621_FIXED_PINIO
+template <uint8_t PIN>
+class HT1621FixedPin
+{
+public:
+    static inline void high() { sio_hw->gpio_set = 1ul << PIN; }
+    static inline void low() { sio_hw->gpio_clr = 1ul << PIN; }
+};
+
+#elif !defined(HT1621_PINIO_AVR)
+
+#define HT1621_FIXED_PINIO
+template <uint8_t PIN>
+class HT1621FixedPin
+{
+public:
+    static inline void high() { digitalWrite(PIN, HIGH); }
+    static inline void low() { digitalWrite(PIN, LOW); }
+};
+
+#endif
+
+template <uint8_t CS, uint8_t RW, uint8_t DATA>
+class HT1621Fixed : public HT1621
+{
+public:
+    HT1621Fixed()
+        : HT1621(CS, RW, DATA)
+    {
+#if defined(HT1621_FIXED_PINIO)
+        _writeBitFunction = writeBit;
+#endif
+    }
+
+#if defined(HT1621_FIXED_PINIO)
+private:
+    // same sequence as HT1621::writeBit()
+    static void writeBit(bool bit, uint8_t clkLowUs, uint8_t clkHighUs)
+    {
+        HT1621FixedPin<RW>::low();
+        if (bit)
+            HT1621FixedPin<DATA>::high();
+        else
+            HT1621FixedPin<DATA>::low();
+        delayMicroseconds(clkLowUs);
+        HT1621FixedPin<RW>::high();
+        delayMicroseconds(clkHighUs);
+    }
+#endif
+};
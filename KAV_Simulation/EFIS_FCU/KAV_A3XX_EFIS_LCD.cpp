@@ -1,85 +1,74 @@
 #include "KAV_A3XX_EFIS_LCD.h"
 
-#define DIGIT_ONE   0
-#define DIGIT_TWO   1
-#define DIGIT_THREE 2
-#define DIGIT_FOUR  3
+// numeric fields, the index into EFISFields[]
+enum Fields : uint8_t {
+    BARO
+};
+static const SegmentField EFISFields[] PROGMEM = {
+    {0, 4}, // QNH or QFE
+};
 
-#define SET_BUFF_BIT(addr, bit, enabled) buffer[addr] = (buffer[addr] & (~(1 << (bit)))) | (((enabled & 1)) << (bit))
+// segments which are not part of a glyph, bit 4 of each digit
+enum Segments : uint8_t {
+    DOT       = SEGMENT(1, 4),
+    QFE_LABEL = SEGMENT(2, 4),
+    QNH_LABEL = SEGMENT(3, 4)
+};
 
-void KAV_A3XX_EFIS_LCD::begin()
-{
-    ht_efis.begin();
-    ht_efis.sendCommand(HT1621::RC256K);
-    ht_efis.sendCommand(HT1621::BIAS_THIRD_4_COM);
-    ht_efis.sendCommand(HT1621::SYS_EN);
-    ht_efis.sendCommand(HT1621::LCD_ON);
-    // This clears the LCD
-    for (uint8_t i = 0; i < ht_efis.MAX_ADDR; i++)
-        ht_efis.write(i, 0);
-
-    // Initialises the buffer to all 0's.
-    memset(buffer, 0, BUFFER_SIZE_MAX);
-}
+static const uint8_t digitPatternEFIS[14] PROGMEM = {
+    0b11101011, // 0
+    0b01100000, // 1
+    0b11000111, // 2
+    0b11100101, // 3
+    0b01101100, // 4
+    0b10101101, // 5 or S
+    0b10101111, // 6
+    0b11100000, // 7
+    0b11101111, // 8
+    0b11101101, // 9
+    0b00000100, // -
+    0b00001111, // t
+    0b01100111, // d
+    0b00000000, // blank
+};
+#define GLYPH_S     5
+#define GLYPH_T     11
+#define GLYPH_D     12
+#define GLYPH_BLANK 13
 
-void KAV_A3XX_EFIS_LCD::attach(byte CS, byte CLK, byte DATA)
-{
-    _CS          = CS;
-    _CLK         = CLK;
-    _DATA        = DATA;
-    _initialised = true;
-    begin();
-}
-void KAV_A3XX_EFIS_LCD::detach()
-{
-    if (!_initialised)
-        return;
-    _initialised = false;
-}
+static const SegmentLayout EFISLayout PROGMEM = {digitPatternEFIS, 14, GLYPH_BLANK, 0b00010000, EFISFields};
 
-void KAV_A3XX_EFIS_LCD::refreshLCD(uint8_t address)
-{
-    ht_efis.write(address * 2, buffer[address], 8);
-}
-void KAV_A3XX_EFIS_LCD::clearLCD()
+KAV_A3XX_EFIS_LCD::KAV_A3XX_EFIS_LCD(uint8_t CS, uint8_t CLK, uint8_t DATA)
+    : SegmentLCD(CS, CLK, DATA, &EFISLayout)
 {
-    for (uint8_t i = 0; i < ht_efis.MAX_ADDR; i++)
-        ht_efis.write(i, 0);
-    memset(buffer, 0, BUFFER_SIZE_MAX);
 }
 
 // QFE, QNH and Dot Functions
 void KAV_A3XX_EFIS_LCD::setQFE(bool enabled)
 {
-    SET_BUFF_BIT(DIGIT_THREE, 4, enabled);
-    refreshLCD(DIGIT_THREE);
+    setSegment(QFE_LABEL, enabled);
 }
 
 void KAV_A3XX_EFIS_LCD::setQNH(bool enabled)
 {
-    SET_BUFF_BIT(DIGIT_FOUR, 4, enabled);
-    refreshLCD(DIGIT_FOUR);
+    setSegment(QNH_LABEL, enabled);
 }
 
 void KAV_A3XX_EFIS_LCD::setDot(bool enabled)
 {
-    SET_BUFF_BIT(DIGIT_TWO, 4, enabled);
-    refreshLCD(DIGIT_TWO);
+    setSegment(DOT, enabled);
 }
 
 void KAV_A3XX_EFIS_LCD::showStd(uint16_t state)
 {
     // if (state == 1) {
     if (state) {
-        displayDigit(DIGIT_ONE, 5);
-        displayDigit(DIGIT_TWO, 11);
-        displayDigit(DIGIT_THREE, 12);
-        displayDigit(DIGIT_FOUR, 13);
+        displayDigit(fieldAddress(BARO), GLYPH_S);
+        displayDigit(fieldAddress(BARO) + 1, GLYPH_T);
+        displayDigit(fieldAddress(BARO) + 2, GLYPH_D);
+        displayDigit(fieldAddress(BARO) + 3, GLYPH_BLANK);
     } else {
-        displayDigit(DIGIT_ONE, 13);
-        displayDigit(DIGIT_TWO, 13);
-        displayDigit(DIGIT_THREE, 13);
-        displayDigit(DIGIT_FOUR, 13);
+        fillField(BARO, GLYPH_BLANK);
     }
     setDot(false);
     setQFE(false);
@@ -89,13 +78,7 @@ void KAV_A3XX_EFIS_LCD::showStd(uint16_t state)
 // Show Values
 void KAV_A3XX_EFIS_LCD::showQNHValue(uint16_t value)
 {
-    if (value > 9999) value = 9999;
-    displayDigit(DIGIT_FOUR, (value % 10));
-    value = value / 10;
-    displayDigit(DIGIT_THREE, (value % 10));
-    value = value / 10;
-    displayDigit(DIGIT_TWO, (value % 10));
-    displayDigit(DIGIT_ONE, (value / 10));
+    showValue(BARO, value);
 
     setDot(false);
     setQFE(false);
@@ -104,47 +87,20 @@ void KAV_A3XX_EFIS_LCD::showQNHValue(uint16_t value)
 
 void KAV_A3XX_EFIS_LCD::showQFEValue(uint16_t value)
 {
-    if (value > 9999) value = 9999;
-    displayDigit(DIGIT_FOUR, (value % 10));
-    value = value / 10;
-    displayDigit(DIGIT_THREE, (value % 10));
-    value = value / 10;
-    displayDigit(DIGIT_TWO, (value % 10));
-    displayDigit(DIGIT_ONE, (value / 10));
+    showValue(BARO, value);
 
     setDot(true);
     setQFE(true);
     setQNH(false);
 }
 
-// Global Functions
-uint8_t digitPatternEFIS[14] = {
-    0b11101011, // 0
-    0b01100000, // 1
-    0b11000111, // 2
-    0b11100101, // 3
-    0b01101100, // 4
-    0b10101101, // 5 or S
-    0b10101111, // 6
-    0b11100000, // 7
-    0b11101111, // 8
-    0b11101101, // 9
-    0b00000100, // -
-    0b00001111, // t
-    0b01100111, // d
-    0b00000000, // blank
-};
-void KAV_A3XX_EFIS_LCD::displayDigit(uint8_t address, uint8_t digit)
+void KAV_A3XX_EFIS_LCD::set(int8_t messageID, char *setPoint)
 {
-    // This ensures that anything over 12 is turned to 'blank', and as it's unsigned, anything less than 0 will become 255, and therefore, 'blank'.
-    if (digit > 13) digit = 13;
-
-    buffer[address] = (buffer[address] & 16) | digitPatternEFIS[digit];
-
-    refreshLCD(address);
+    stage(messageID, setPoint);
+    ht.flush();
 }
 
-void KAV_A3XX_EFIS_LCD::set(int8_t messageID, char *setPoint)
+void KAV_A3XX_EFIS_LCD::stage(int8_t messageID, char *setPoint)
 {
     int32_t data = atoi(setPoint);
     /* **********************************************************************************
@@ -166,4 +122,7 @@ void KAV_A3XX_EFIS_LCD::set(int8_t messageID, char *setPoint)
         showQFEValue((uint16_t)data);
     else if (messageID == 2)
         showStd((uint16_t)data);
+
+    // all functions above change only the buffer, copy the result once per message
+    stageLCD();
 }
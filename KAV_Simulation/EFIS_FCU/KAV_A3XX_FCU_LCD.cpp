@@ -1,41 +1,76 @@
 #include "KAV_A3XX_FCU_LCD.h"
 
-#define SPD_HUN  0
-#define SPD_TEN  1
-#define SPD_UNIT 2
-#define HDG_HUN  3
-#define HDG_TEN  4
-#define HDG_UNIT 5
-#define ALT_TTH  6
-#define ALT_THO  7
-#define ALT_HUN  8
-#define ALT_TEN  9
-#define ALT_UNIT 10
-#define VRT_THO  11
-#define VRT_HUN  12
-#define VRT_TEN  13
-#define VRT_UNIT 14
-#define SPECIALS 15
+// numeric fields, the index into FCUFields[]
+enum Fields : uint8_t {
+    SPEED,
+    HEADING,
+    ALTITUDE,
+    VERTICAL
+};
+static const SegmentField FCUFields[] PROGMEM = {
+    {0, 3},  // speed
+    {3, 3},  // heading
+    {6, 5},  // altitude
+    {11, 4}, // vertical speed or FPA
+};
 
-#define SET_BUFF_BITS(addr, bitMask, enabledMask) buffer[addr] = (buffer[addr] & (~(bitMask))) | (enabledMask)
-#define SET_BUFF_BIT(addr, bit, enabled)          buffer[addr] = (buffer[addr] & (~(1 << (bit)))) | (((enabled & 1)) << (bit))
+// segments which are not part of a glyph, bit 0 of each digit and the specials at address 15
+enum Segments : uint8_t {
+    SPEED_LABEL        = SEGMENT(15, 7),
+    MACH_LABEL         = SEGMENT(15, 6),
+    HEADING_LABEL      = SEGMENT(15, 5),
+    TRACK_LABEL        = SEGMENT(15, 4),
+    FPA_LABEL          = SEGMENT(15, 3),
+    VRTSPD_LABEL       = SEGMENT(15, 2),
+    LVLCH_LABEL        = SEGMENT(15, 1),
+    ALTITUDE_LABEL     = SEGMENT(15, 0),
+    MACH_DECIMAL_POINT = SEGMENT(1, 0),
+    SPEED_DOT          = SEGMENT(3, 0),
+    LATITUDE_LABEL     = SEGMENT(4, 0),
+    HEADING_DOT        = SEGMENT(5, 0),
+    FPA_LABEL_2        = SEGMENT(6, 0),  // the labels below are switched together with the ones above
+    VRTSPD_LABEL_2     = SEGMENT(7, 0),
+    TRACK_LABEL_2      = SEGMENT(8, 0),
+    HEADING_LABEL_2    = SEGMENT(9, 0),
+    ALTITUDE_DOT       = SEGMENT(11, 0),
+    FPA_DECIMAL_POINT  = SEGMENT(12, 0),
+    VERTICAL_PLUS      = SEGMENT(13, 0), // the vertical bar of the plus sign
+    VERTICAL_MINUS     = SEGMENT(14, 0)
+};
 
-void KAV_A3XX_FCU_LCD::begin()
+static const uint8_t digitPatternFCU[13] PROGMEM = {
+    0b11111010, // 0
+    0b01100000, // 1
+    0b10111100, // 2
+    0b11110100, // 3
+    0b01100110, // 4
+    0b11010110, // 5
+    0b11011110, // 6
+    0b01110000, // 7
+    0b11111110, // 8
+    0b11110110, // 9
+    0b00000100, // -
+    0b00000000, // blank
+    0b11001100, // small 0 (For V/S)
+};
+#define GLYPH_DASH   10
+#define GLYPH_BLANK  11
+#define GLYPH_SMALL0 12
+
+static const SegmentLayout FCULayout PROGMEM = {digitPatternFCU, 13, GLYPH_BLANK, 0b00000001, FCUFields};
+
+KAV_A3XX_FCU_LCD::KAV_A3XX_FCU_LCD(uint8_t CS, uint8_t CLK, uint8_t DATA)
+    : SegmentLCD(CS, CLK, DATA, &FCULayout), vertSignEnabled(true)
 {
-    ht.begin();
-    ht.sendCommand(HT1621::RC256K);
-    ht.sendCommand(HT1621::BIAS_THIRD_4_COM);
-    ht.sendCommand(HT1621::SYS_EN);
-    ht.sendCommand(HT1621::LCD_ON);
-    // This clears the LCD
-    for (uint8_t i = 0; i < ht.MAX_ADDR; i++)
-        ht.write(i, 0);
+}
 
-    // Initialises the buffer to all 0's.
-    memset(buffer, 0, BUFFER_SIZE_MAX);
+void KAV_A3XX_FCU_LCD::begin()
+{
+    SegmentLCD::begin();
     pinMode(10, OUTPUT);
     digitalWrite(10, HIGH);
     setStartLabels();
+    refreshLCD();
 }
 
 void KAV_A3XX_FCU_LCD::attach(byte CS, byte CLK, byte DATA)
@@ -46,36 +81,17 @@ void KAV_A3XX_FCU_LCD::attach(byte CS, byte CLK, byte DATA)
     _initialised = true;
     begin();
 }
-void KAV_A3XX_FCU_LCD::detach()
-{
-    if (!_initialised)
-        return;
-    _initialised = false;
-}
-
-void KAV_A3XX_FCU_LCD::refreshLCD(uint8_t address)
-{
-    ht.write(address * 2, buffer[address], 8);
-}
-void KAV_A3XX_FCU_LCD::clearLCD()
-{
-    for (uint8_t i = 0; i < ht.MAX_ADDR; i++)
-        ht.write(i, 0);
-    memset(buffer, 0, BUFFER_SIZE_MAX);
-}
 
 // Speed
 void KAV_A3XX_FCU_LCD::setSpeedLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 7, enabled);
-    refreshLCD(SPECIALS);
+    setSegment(SPEED_LABEL, enabled);
 }
 
 void KAV_A3XX_FCU_LCD::setMachLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 6, enabled);
-    SET_BUFF_BIT(SPD_TEN, 0, enabled); // Decimal-point
-    refreshLCD(SPECIALS);
+    setSegment(MACH_LABEL, enabled);
+    setSegment(MACH_DECIMAL_POINT, enabled); // Decimal-point
 }
 
 void KAV_A3XX_FCU_LCD::setSpeedDot(int8_t state)
@@ -85,38 +101,28 @@ void KAV_A3XX_FCU_LCD::setSpeedDot(int8_t state)
         enabled = false;
     else
         enabled = true;
-    SET_BUFF_BIT(HDG_HUN, 0, enabled);
-    refreshLCD(HDG_HUN);
+    setSegment(SPEED_DOT, enabled);
 }
 
 void KAV_A3XX_FCU_LCD::showSpeedValue(uint16_t value)
 {
-    if (value > 999) value = 999;
-    displayDigit(SPD_UNIT, (value % 10));
-    value = value / 10;
-    displayDigit(SPD_TEN, (value % 10));
-    displayDigit(SPD_HUN, (value / 10));
+    showValue(SPEED, value);
 }
 
 // Heading
 void KAV_A3XX_FCU_LCD::setHeadingLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 5, enabled);
-    SET_BUFF_BIT(ALT_TEN, 0, enabled);
-    refreshLCD(SPECIALS);
-    refreshLCD(ALT_TEN);
+    setSegment(HEADING_LABEL, enabled);
+    setSegment(HEADING_LABEL_2, enabled);
 }
 void KAV_A3XX_FCU_LCD::setTrackLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 4, enabled);
-    SET_BUFF_BIT(ALT_HUN, 0, enabled);
-    refreshLCD(SPECIALS);
-    refreshLCD(ALT_HUN);
+    setSegment(TRACK_LABEL, enabled);
+    setSegment(TRACK_LABEL_2, enabled);
 }
 void KAV_A3XX_FCU_LCD::setLatitudeLabel(bool enabled)
 {
-    SET_BUFF_BIT(HDG_TEN, 0, enabled);
-    refreshLCD(HDG_TEN);
+    setSegment(LATITUDE_LABEL, enabled);
 }
 void KAV_A3XX_FCU_LCD::setHeadingDot(int8_t state)
 {
@@ -125,29 +131,22 @@ void KAV_A3XX_FCU_LCD::setHeadingDot(int8_t state)
         enabled = false;
     else
         enabled = true;
-    SET_BUFF_BIT(HDG_UNIT, 0, enabled);
-    refreshLCD(HDG_UNIT);
+    setSegment(HEADING_DOT, enabled);
 }
 
 void KAV_A3XX_FCU_LCD::showHeadingValue(uint16_t value)
 {
-    if (value > 999) value = 999;
-    displayDigit(HDG_UNIT, (value % 10));
-    value = value / 10;
-    displayDigit(HDG_TEN, (value % 10));
-    displayDigit(HDG_HUN, (value / 10));
+    showValue(HEADING, value);
 }
 
 // Altitude
 void KAV_A3XX_FCU_LCD::setAltitudeLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 0, enabled);
-    refreshLCD(SPECIALS);
+    setSegment(ALTITUDE_LABEL, enabled);
 }
 void KAV_A3XX_FCU_LCD::setLvlChLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 1, enabled);
-    refreshLCD(SPECIALS);
+    setSegment(LVLCH_LABEL, enabled);
 }
 void KAV_A3XX_FCU_LCD::setAltitudeDot(int8_t state)
 {
@@ -156,36 +155,23 @@ void KAV_A3XX_FCU_LCD::setAltitudeDot(int8_t state)
         enabled = false;
     else
         enabled = true;
-    SET_BUFF_BIT(VRT_THO, 0, enabled);
-    refreshLCD(VRT_THO);
+    setSegment(ALTITUDE_DOT, enabled);
 }
 void KAV_A3XX_FCU_LCD::showAltitudeValue(uint32_t value)
 {
-    if (value > 99999) value = 99999;
-    displayDigit(ALT_UNIT, (value % 10));
-    value = value / 10;
-    displayDigit(ALT_TEN, (value % 10));
-    value = value / 10;
-    displayDigit(ALT_HUN, (value % 10));
-    value = value / 10;
-    displayDigit(ALT_THO, (value % 10));
-    displayDigit(ALT_TTH, (value / 10));
+    showValue(ALTITUDE, value);
 }
 
 // Vertical
 void KAV_A3XX_FCU_LCD::setVrtSpdLabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 2, enabled);
-    SET_BUFF_BIT(ALT_THO, 0, enabled);
-    refreshLCD(SPECIALS);
-    refreshLCD(ALT_THO);
+    setSegment(VRTSPD_LABEL, enabled);
+    setSegment(VRTSPD_LABEL_2, enabled);
 }
 void KAV_A3XX_FCU_LCD::setFPALabel(bool enabled)
 {
-    SET_BUFF_BIT(SPECIALS, 3, enabled);
-    SET_BUFF_BIT(ALT_TTH, 0, enabled);
-    refreshLCD(SPECIALS);
-    refreshLCD(ALT_TTH);
+    setSegment(FPA_LABEL, enabled);
+    setSegment(FPA_LABEL_2, enabled);
 }
 void KAV_A3XX_FCU_LCD::setSignLabel(bool enabled)
 {
@@ -197,25 +183,23 @@ void KAV_A3XX_FCU_LCD::showVerticalValue(int16_t value)
     if (value < -9999) value = -9999;
     if (value < 0) {
         value = -value;
-        SET_BUFF_BIT(VRT_TEN, 0, false);
-        SET_BUFF_BIT(VRT_UNIT, 0, vertSignEnabled);
-        SET_BUFF_BIT(VRT_HUN, 0, false);
+        setSegment(VERTICAL_PLUS, false);
+        setSegment(VERTICAL_MINUS, vertSignEnabled);
+        setSegment(FPA_DECIMAL_POINT, false);
     } else if (value == 0) {
-        SET_BUFF_BIT(VRT_TEN, 0, false);
-        SET_BUFF_BIT(VRT_UNIT, 0, false);
-        SET_BUFF_BIT(VRT_HUN, 0, false);
+        setSegment(VERTICAL_PLUS, false);
+        setSegment(VERTICAL_MINUS, false);
+        setSegment(FPA_DECIMAL_POINT, false);
     } else {
-        SET_BUFF_BIT(VRT_TEN, 0, vertSignEnabled);
-        SET_BUFF_BIT(VRT_UNIT, 0, vertSignEnabled);
-        SET_BUFF_BIT(VRT_HUN, 0, false);
+        setSegment(VERTICAL_PLUS, vertSignEnabled);
+        setSegment(VERTICAL_MINUS, vertSignEnabled);
+        setSegment(FPA_DECIMAL_POINT, false);
     }
 
-    displayDigit(VRT_UNIT, 12);
-    value = value / 10;
-    displayDigit(VRT_TEN, 12);
-    value = value / 10;
-    displayDigit(VRT_HUN, (value % 10));
-    displayDigit(VRT_THO, (value / 10));
+    // hundreds and thousands, the last two digits are always a small 0
+    showNumber(fieldAddress(VERTICAL), 2, value / 100);
+    displayDigit(fieldAddress(VERTICAL) + 2, GLYPH_SMALL0);
+    displayDigit(fieldAddress(VERTICAL) + 3, GLYPH_SMALL0);
 }
 void KAV_A3XX_FCU_LCD::showFPAValue(int8_t value)
 {
@@ -223,21 +207,18 @@ void KAV_A3XX_FCU_LCD::showFPAValue(int8_t value)
     if (value < -99) value = -99;
     if (value < 0) {
         value = -value;
-        SET_BUFF_BIT(VRT_TEN, 0, false);
-        SET_BUFF_BIT(VRT_UNIT, 0, vertSignEnabled);
-        SET_BUFF_BIT(VRT_HUN, 0, true);
+        setSegment(VERTICAL_PLUS, false);
+        setSegment(VERTICAL_MINUS, vertSignEnabled);
+        setSegment(FPA_DECIMAL_POINT, true);
     } else {
-        SET_BUFF_BIT(VRT_TEN, 0, vertSignEnabled);
-        SET_BUFF_BIT(VRT_UNIT, 0, vertSignEnabled);
-        SET_BUFF_BIT(VRT_HUN, 0, true);
+        setSegment(VERTICAL_PLUS, vertSignEnabled);
+        setSegment(VERTICAL_MINUS, vertSignEnabled);
+        setSegment(FPA_DECIMAL_POINT, true);
     }
 
-    displayDigit(VRT_HUN, (value % 10));
-    displayDigit(VRT_THO, (value / 10));
-    SET_BUFF_BITS(VRT_TEN, 0b11111110, 0);
-    SET_BUFF_BITS(VRT_UNIT, 0b11111110, 0);
-    refreshLCD(VRT_TEN);
-    refreshLCD(VRT_UNIT);
+    showNumber(fieldAddress(VERTICAL), 2, value);
+    clearDigit(fieldAddress(VERTICAL) + 2);
+    clearDigit(fieldAddress(VERTICAL) + 3);
 }
 
 // Preset States
@@ -250,14 +231,11 @@ void KAV_A3XX_FCU_LCD::setSpeedDashes(int8_t state)
     else
         enabled = true;
     if (enabled)
-        val = 10;
+        val = GLYPH_DASH;
     else
-        val = 11;
-    displayDigit(SPD_HUN, val);
-    displayDigit(SPD_TEN, val);
-    displayDigit(SPD_UNIT, val);
-    SET_BUFF_BIT(SPD_TEN, 0, false); // Clear Mach Decimal-point
-    refreshLCD(SPECIALS);
+        val = GLYPH_BLANK;
+    fillField(SPEED, val);
+    setSegment(MACH_DECIMAL_POINT, false); // Clear Mach Decimal-point
 }
 
 void KAV_A3XX_FCU_LCD::setHeadingDashes(int8_t state)
@@ -269,12 +247,10 @@ void KAV_A3XX_FCU_LCD::setHeadingDashes(int8_t state)
     else
         enabled = true;
     if (enabled)
-        val = 10;
+        val = GLYPH_DASH;
     else
-        val = 11;
-    displayDigit(HDG_HUN, val);
-    displayDigit(HDG_TEN, val);
-    displayDigit(HDG_UNIT, val);
+        val = GLYPH_BLANK;
+    fillField(HEADING, val);
 }
 void KAV_A3XX_FCU_LCD::setAltitudeDashes(int8_t state)
 {
@@ -285,14 +261,10 @@ void KAV_A3XX_FCU_LCD::setAltitudeDashes(int8_t state)
     else
         enabled = true;
     if (enabled)
-        val = 10;
+        val = GLYPH_DASH;
     else
-        val = 11;
-    displayDigit(ALT_TTH, val);
-    displayDigit(ALT_THO, val);
-    displayDigit(ALT_HUN, val);
-    displayDigit(ALT_TEN, val);
-    displayDigit(ALT_UNIT, val);
+        val = GLYPH_BLANK;
+    fillField(ALTITUDE, val);
 }
 void KAV_A3XX_FCU_LCD::setVrtSpdDashes(int8_t state)
 {
@@ -303,17 +275,14 @@ void KAV_A3XX_FCU_LCD::setVrtSpdDashes(int8_t state)
     else
         enabled = true;
     if (enabled) {
-        val = 10;
-        SET_BUFF_BIT(VRT_UNIT, 0, true); // Set the plus/minus to minus
-        SET_BUFF_BIT(VRT_TEN, 0, false); // Remove the plus segment
+        val = GLYPH_DASH;
+        setSegment(VERTICAL_MINUS, true); // Set the plus/minus to minus
+        setSegment(VERTICAL_PLUS, false); // Remove the plus segment
     } else {
-        val = 11;
-        SET_BUFF_BIT(VRT_UNIT, 0, false); // Turn it off
+        val = GLYPH_BLANK;
+        setSegment(VERTICAL_MINUS, false); // Turn it off
     }
-    displayDigit(VRT_THO, val);
-    displayDigit(VRT_HUN, val);
-    displayDigit(VRT_TEN, val);
-    displayDigit(VRT_UNIT, val);
+    fillField(VERTICAL, val);
 }
 void KAV_A3XX_FCU_LCD::setStartLabels()
 {
@@ -357,33 +326,13 @@ void KAV_A3XX_FCU_LCD::setMachMode(uint16_t value)
     showSpeedValue(value);
 }
 
-// Global Functions
-uint8_t digitPatternFCU[13] = {
-    0b11111010, // 0
-    0b01100000, // 1
-    0b10111100, // 2
-    0b11110100, // 3
-    0b01100110, // 4
-    0b11010110, // 5
-    0b11011110, // 6
-    0b01110000, // 7
-    0b11111110, // 8
-    0b11110110, // 9
-    0b00000100, // -
-    0b00000000, // blank
-    0b11001100, // small 0 (For V/S)
-};
-void KAV_A3XX_FCU_LCD::displayDigit(uint8_t address, uint8_t digit)
+void KAV_A3XX_FCU_LCD::set(int8_t messageID, char *setPoint)
 {
-    // This ensures that anything over 12 is turned to 'blank', and as it's unsigned, anything less than 0 will become 255, and therefore, 'blank'.
-    if (digit > 12) digit = 11;
-
-    buffer[address] = (buffer[address] & 1) | digitPatternFCU[digit];
-
-    refreshLCD(address);
+    stage(messageID, setPoint);
+    ht.flush();
 }
 
-void KAV_A3XX_FCU_LCD::set(int8_t messageID, char *setPoint)
+void KAV_A3XX_FCU_LCD::stage(int8_t messageID, char *setPoint)
 {
     int32_t data = atoi(setPoint);
     /* **********************************************************************************
@@ -433,4 +382,7 @@ void KAV_A3XX_FCU_LCD::set(int8_t messageID, char *setPoint)
         setMachLabel((int8_t)data);
     else if (messageID == 16)
         showSpeedValue((uint16_t)data);
+
+    // all functions above change only the buffer, copy the result once per message
+    stageLCD();
 }
@@ -7,39 +7,28 @@
 #pragma once
 
 #include "Arduino.h"
-#include "HT1621.h"
+#include "SegmentLCD.h"
 
-#define BUFFER_SIZE_MAX 16
+// number of messageIDs, starting from 0
+#define FCU_MESSAGES 17
 
-class KAV_A3XX_FCU_LCD
+class KAV_A3XX_FCU_LCD : public SegmentLCD
 {
 private:
     // Fields
-    HT1621  ht;
-    uint8_t buffer[BUFFER_SIZE_MAX];
-    bool    vertSignEnabled;
-    bool    _initialised;
-    byte    _CS;
-    byte    _CLK;
-    byte    _DATA;
-    bool    trkActive;
-
-    // Methods
-    void displayDigit(uint8_t address, uint8_t digit);
-    // void setBufferBit(uint8_t address, uint8_t bit, uint8_t enabled);
-    void refreshLCD(uint8_t address);
+    bool vertSignEnabled;
+    bool trkActive;
 
 public:
     // Constructor
     // 'CLK' is sometimes referred to as 'RW'
-    KAV_A3XX_FCU_LCD(uint8_t CS, uint8_t CLK, uint8_t DATA)
-        : ht(CS, CLK, DATA), vertSignEnabled(true){};
+    KAV_A3XX_FCU_LCD(uint8_t CS, uint8_t CLK, uint8_t DATA);
 
     void begin();
-    void clearLCD();
     void attach(byte CS, byte CLK, byte DATA);
-    void detach();
     void set(int8_t messageID, char *setPoint);
+    // like set(), but the changes are only written to the shadow RAM of the HT1621, flush() sends them
+    void stage(int8_t messageID, char *setPoint);
 
     // Speed and Mach functions
     void setSpeedLabel(bool enabled);
@@ -0,0 +1,66 @@
+#include "KAV_A3XX_Glareshield.h"
+
+KAV_A3XX_Glareshield::KAV_A3XX_Glareshield(const uint8_t CS[3], uint8_t CLK, const uint8_t DATA[3])
+    : fcu(CS[0], CLK, DATA[0]), efisLeft(CS[1], CLK, DATA[1]), efisRight(CS[2], CLK, DATA[2])
+{
+    ht[0] = fcu.getHT1621();
+    ht[1] = efisLeft.getHT1621();
+    ht[2] = efisRight.getHT1621();
+    memcpy(_CS, CS, sizeof(_CS));
+    memcpy(_DATA, DATA, sizeof(_DATA));
+    _CLK = CLK;
+}
+
+void KAV_A3XX_Glareshield::attach()
+{
+    fcu.attach(_CS[0], _CLK, _DATA[0]);
+    efisLeft.attach(_CS[1], _CLK, _DATA[1]);
+    efisRight.attach(_CS[2], _CLK, _DATA[2]);
+    _initialised = true;
+}
+
+void KAV_A3XX_Glareshield::detach()
+{
+    if (!_initialised)
+        return;
+    fcu.detach();
+    efisLeft.detach();
+    efisRight.detach();
+    _initialised = false;
+}
+
+void KAV_A3XX_Glareshield::set(int8_t messageID, char *setPoint)
+{
+    /* **********************************************************************************
+        MessageID == -1 and -2 clear all displays, see KAV_A3XX_FCU_LCD::set()
+    ********************************************************************************** */
+    if (messageID < 0) {
+        fcu.stage(messageID, setPoint);
+        efisLeft.stage(messageID, setPoint);
+        efisRight.stage(messageID, setPoint);
+    } else if (messageID < GLARESHIELD_EFIS_LEFT) {
+        fcu.stage(messageID, setPoint);
+    } else if (messageID < GLARESHIELD_EFIS_RIGHT) {
+        efisLeft.stage(messageID - GLARESHIELD_EFIS_LEFT, setPoint);
+    } else if (messageID < GLARESHIELD_EFIS_BOTH) {
+        efisRight.stage(messageID - GLARESHIELD_EFIS_RIGHT, setPoint);
+    } else if (messageID < GLARESHIELD_MESSAGES) {
+        efisLeft.stage(messageID - GLARESHIELD_EFIS_BOTH, setPoint);
+        efisRight.stage(messageID - GLARESHIELD_EFIS_BOTH, setPoint);
+    }
+
+    // the drivers change only the shadow RAM, all displays which have changed are written together
+    HT1621::flush(ht, 3);
+}
+
+void KAV_A3XX_Glareshield::update()
+{
+    fcu.update();
+    efisLeft.update();
+    efisRight.update();
+}
+
+HT1621 *KAV_A3XX_Glareshield::getHT1621(uint8_t display)
+{
+    return ht[display];
+}
@@ -0,0 +1,48 @@
+/**
+ * KAV A3XX Glareshield
+ * Drives the FCU and both EFIS LCDs of the 'Kav Simulations' glareshield as one device.
+ * All displays share the CLK pin, so the changes of one message are written to all of them at once.
+ * Boards with a separate CLK pin for each display must be rewired or use the KAV_FCU and KAV_EFIS devices.
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "KAV_A3XX_FCU_LCD.h"
+#include "KAV_A3XX_EFIS_LCD.h"
+
+/* **********************************************************************************
+    messageIDs 0 to 16 are the messageIDs of the FCU.
+    Each EFIS block has the messageIDs of the EFIS (QNH, QFE, STD) in the same order,
+    the last block sets both EFIS with one message.
+********************************************************************************** */
+#define GLARESHIELD_EFIS_LEFT  17
+#define GLARESHIELD_EFIS_RIGHT 20
+#define GLARESHIELD_EFIS_BOTH  23
+#define GLARESHIELD_MESSAGES   26
+
+class KAV_A3XX_Glareshield
+{
+private:
+    // Fields
+    KAV_A3XX_FCU_LCD  fcu;
+    KAV_A3XX_EFIS_LCD efisLeft;
+    KAV_A3XX_EFIS_LCD efisRight;
+    HT1621           *ht[3];
+    bool              _initialised = false;
+    byte              _CS[3];
+    byte              _CLK;
+    byte              _DATA[3];
+
+public:
+    // Constructor
+    // The pins are in the order FCU, left EFIS, right EFIS
+    KAV_A3XX_Glareshield(const uint8_t CS[3], uint8_t CLK, const uint8_t DATA[3]);
+
+    void attach();
+    void detach();
+    void set(int8_t messageID, char *setPoint);
+    void update();
+    // gives access to the bus statistics of the drivers, 0 = FCU, 1 = left EFIS, 2 = right EFIS
+    HT1621 *getHT1621(uint8_t display);
+};
@@ -1,47 +1,42 @@
 #include "MFCustomDevice.h"
 #include "commandmessenger.h"
 #include "allocateMem.h"
-#include "MFEEPROM.h"
-extern MFEEPROM MFeeprom;
+#include "../../_common/CustomDeviceConfig.h"
 
 /* **********************************************************************************
     The custom device pins, type and configuration is stored in the EEPROM
     While loading the config the adresses in the EEPROM are transferred to the constructor
-    Within the constructor you have to copy the EEPROM content to a buffer
-    and evaluate him. The buffer is used for all 3 types (pins, type configuration),
-    so do it step by step.
-    The max size of the buffer is defined here. It must be the size of the
-    expected max length of these strings.
-    E.g. 6 pins are required, each pin could have two characters (two digits),
-    each pins are delimited by "|" and the string is NULL terminated.
-    -> (6 * 2) + 5 + 1 = 18 bytes is the maximum.
-    The custom type is "MyCustomDevice", which means 14 characters plus NULL = 15
-    The configuration is "myConfig", which means 8 characters plus NULL = 9
-    The maximum characters to be expected is 18, so MEMLEN_STRING_BUFFER has to be at least 18
-
-    For the KAV displays:
-    3 Pins = 9
-    "KAV_EFIS" / "KAV_FCU" = 9
-    no config = 0
+    They are read with the helpers in _common/CustomDeviceConfig.h
 ********************************************************************************** */
 
-#define MEMLEN_STRING_BUFFER 10
+/* **********************************************************************************
+    Messages which render into the same digits belong to the same group (0 = no group).
+    If the value of one of them changes, the others have to be rendered again even if
+    their value is repeated. E.g. the speed dashes overwrite the speed value.
+********************************************************************************** */
+static const uint8_t FCUMessageGroups[FCU_MESSAGES] PROGMEM = {
+    1, 1, 2, 3, 4, 4, // speed, mach, heading, altitude, vertical, FPA
+    1, 2, 3, 4,       // dashes
+    0, 0, 0, 0,       // dots, Trk/Hdg mode
+    1, 1, 1           // speed label, mach label, speed only
+};
+static const uint8_t EFISMessageGroups[EFIS_MESSAGES] PROGMEM = {
+    1, 1, 1 // QNH, QFE and STD share all digits
+};
+static const uint8_t GlareshieldMessageGroups[GLARESHIELD_MESSAGES] PROGMEM = {
+    1, 1, 2, 3, 4, 4, // FCU like above
+    1, 2, 3, 4,
+    0, 0, 0, 0,
+    1, 1, 1,
+    5, 5, 5, // left EFIS, right EFIS and both EFIS render into the same digits
+    5, 5, 5,
+    5, 5, 5
+};
 
-// reads a string from EEPROM at given address which is '.' terminated and saves it to the buffer
-bool MFCustomDevice::getStringFromEEPROM(uint16_t addreeprom, char *buffer)
-{
-    char    temp    = 0;
-    uint8_t counter = 0;
-    do {
-        temp              = MFeeprom.read_byte((addreeprom)++); // read the first character
-        buffer[counter++] = temp;                               // save character and locate next buffer position
-        if (counter >= MEMLEN_STRING_BUFFER) {                  // nameBuffer will be exceeded
-            return false;                                       // abort copying to buffer
-        }
-    } while (temp != '.');      // reads until limiter '.' and locates the next free buffer position
-    buffer[counter - 1] = 0x00; // replace '.' by NULL, terminates the string
-    return true;
-}
+static const char KAVFCUName[] PROGMEM     = "KAV_FCU";
+static const char KAVEFISName[] PROGMEM    = "KAV_EFIS";
+static const char KAVGlareName[] PROGMEM   = "KAV_GLARESHIELD";
+static const char SegmentName[] PROGMEM    = "HT1621_SEGMENT";
 
 /* **********************************************************************************
     Within the connector pins, a device name and a config string can be defined
@@ -58,20 +53,22 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
         Do something which is required to setup your custom device
     ********************************************************************************** */
 
-    char   *params, *p = NULL;
-    char    parameter[MEMLEN_STRING_BUFFER];
-    uint8_t _pin1, _pin2, _pin3;
+    uint8_t pins[7];
+    char    token[MEMLEN_TOKEN_BUFFER];
 
     /* **********************************************************************************
-        Read the Type from the EEPROM, copy it into a buffer and evaluate it
+        Compare the Type in the EEPROM with the supported types
         The string get's NOT stored as this would need a lot of RAM, instead a variable
         is used to store the type
     ********************************************************************************** */
-    getStringFromEEPROM(adrType, parameter);
-    if (strcmp(parameter, "KAV_FCU") == 0)
+    if (CustomDeviceConfig::compareStringFromEEPROM(adrType, KAVFCUName))
         _lcdType = KAV_LCD_FCU;
-    if (strcmp(parameter, "KAV_EFIS") == 0)
+    else if (CustomDeviceConfig::compareStringFromEEPROM(adrType, KAVEFISName))
         _lcdType = KAV_LCD_EFIS;
+    else if (CustomDeviceConfig::compareStringFromEEPROM(adrType, KAVGlareName))
+        _lcdType = KAV_LCD_GLARESHIELD;
+    else if (CustomDeviceConfig::compareStringFromEEPROM(adrType, SegmentName))
+        _lcdType = HT1621_SEGMENT_LCD;
 
     if (_lcdType == KAV_LCD_FCU) {
         /* **********************************************************************************
@@ -84,60 +81,88 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
         }
 
         /* **********************************************************************************************
-            Read the pins from the EEPROM, copy them into a buffer
-            If you have set '"isI2C": true' in the device.json file, the first value is the I2C address
-        ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        /* **********************************************************************************************
-            split the pins up into single pins. As the number of pins could be different between
-            multiple devices, it is done here.
+            read the pins from the EEPROM and split them up into single pins: Data|CS|CLK
         ********************************************************************************************** */
-        params = strtok_r(parameter, "|", &p);
-        _pin1  = atoi(params);
-        params = strtok_r(NULL, "|", &p);
-        _pin2  = atoi(params);
-        params = strtok_r(NULL, "|", &p);
-        _pin3  = atoi(params);
+        CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 3);
 
         /* **********************************************************************************
             Next call the constructor of your custom device
             adapt it to the needs of your constructor
         ********************************************************************************** */
-        _FCU_LCD = new (allocateMemory(sizeof(KAV_A3XX_FCU_LCD))) KAV_A3XX_FCU_LCD(_pin2, _pin3, _pin1);
-        _FCU_LCD->attach(_pin2, _pin3, _pin1);
+        _FCU_LCD = new (allocateMemory(sizeof(KAV_A3XX_FCU_LCD))) KAV_A3XX_FCU_LCD(pins[1], pins[2], pins[0]);
+        _FCU_LCD->attach(pins[1], pins[2], pins[0]);
+        _messageGroups = FCUMessageGroups;
+        allocateCache(FCU_MESSAGES);
         _initialized = true;
     } else if (_lcdType == KAV_LCD_EFIS) {
         /* **********************************************************************************
             Check if the device fits into the device buffer
         ********************************************************************************** */
-        if (!FitInMemory(sizeof(KAV_A3XX_FCU_LCD))) {
+        if (!FitInMemory(sizeof(KAV_A3XX_EFIS_LCD))) {
             // Error Message to Connector
             cmdMessenger.sendCmd(kStatus, F("EFIS LCD does not fit in Memory"));
             return;
         }
 
         /* **********************************************************************************************
-            Read the pins from the EEPROM, copy them into a buffer
-            If you have set '"isI2C": true' in the device.json file, the first value is the I2C address
-        ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        /* **********************************************************************************************
-            split the pins up into single pins. As the number of pins could be different between
-            multiple devices, it is done here.
+            read the pins from the EEPROM and split them up into single pins: Data|CS|CLK
         ********************************************************************************************** */
-        params = strtok_r(parameter, "|", &p);
-        _pin1  = atoi(params);
-        params = strtok_r(NULL, "|", &p);
-        _pin2  = atoi(params);
-        params = strtok_r(NULL, "|", &p);
-        _pin3  = atoi(params);
+        CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 3);
 
         /* **********************************************************************************
             Next call the constructor of your custom device
             adapt it to the needs of your constructor
         ********************************************************************************** */
-        _EFIS_LCD = new (allocateMemory(sizeof(KAV_A3XX_EFIS_LCD))) KAV_A3XX_EFIS_LCD(_pin2, _pin3, _pin1);
-        _EFIS_LCD->attach(_pin2, _pin3, _pin1);
+        _EFIS_LCD = new (allocateMemory(sizeof(KAV_A3XX_EFIS_LCD))) KAV_A3XX_EFIS_LCD(pins[1], pins[2], pins[0]);
+        _EFIS_LCD->attach(pins[1], pins[2], pins[0]);
+        _messageGroups = EFISMessageGroups;
+        allocateCache(EFIS_MESSAGES);
+        _initialized = true;
+    } else if (_lcdType == KAV_LCD_GLARESHIELD) {
+        /* **********************************************************************************
+            Check if the device fits into the device buffer
+        ********************************************************************************** */
+        if (!FitInMemory(sizeof(KAV_A3XX_Glareshield))) {
+            // Error Message to Connector
+            cmdMessenger.sendCmd(kStatus, F("Glareshield LCDs do not fit in Memory"));
+            return;
+        }
+
+        /* **********************************************************************************************
+            read the pins from the EEPROM and split them up into single pins
+            Data FCU|Data left EFIS|Data right EFIS|CS FCU|CS left EFIS|CS right EFIS|CLK
+        ********************************************************************************************** */
+        CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 7);
+        _Glareshield = new (allocateMemory(sizeof(KAV_A3XX_Glareshield))) KAV_A3XX_Glareshield(&pins[3], pins[6], &pins[0]);
+        _Glareshield->attach();
+        _messageGroups = GlareshieldMessageGroups;
+        allocateCache(GLARESHIELD_MESSAGES);
+        _initialized = true;
+    } else if (_lcdType == HT1621_SEGMENT_LCD) {
+        /* **********************************************************************************
+            Check if the device fits into the device buffer
+        ********************************************************************************** */
+        if (!FitInMemory(sizeof(GenericSegmentLCD))) {
+            // Error Message to Connector
+            cmdMessenger.sendCmd(kStatus, F("Segment LCD does not fit in Memory"));
+            return;
+        }
+
+        /* **********************************************************************************************
+            read the pins from the EEPROM and split them up into single pins: Data|CS|CLK
+        ********************************************************************************************** */
+        CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 3);
+        _SegmentLCD = new (allocateMemory(sizeof(GenericSegmentLCD))) GenericSegmentLCD(pins[1], pins[2], pins[0]);
+        /* **********************************************************************************************
+            each token of the config defines the wiring, a field or an annunciator
+            see GenericSegmentLCD.h for the format
+        ********************************************************************************************** */
+        while (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token))) {
+            if (!_SegmentLCD->addConfig(token))
+                cmdMessenger.sendCmd(kStatus, F("Segment LCD config is not valid"));
+        }
+        _SegmentLCD->attach(pins[1], pins[2], pins[0]);
+        allocateCache(GENERIC_SEGMENT_ITEMS);
         _initialized = true;
     } else {
         cmdMessenger.sendCmd(kStatus, F("Custom Device is not supported by this firmware version"));
@@ -151,6 +176,10 @@ void MFCustomDevice::detach()
         _FCU_LCD->detach();
     } else if (_lcdType == KAV_LCD_EFIS) {
         _EFIS_LCD->detach();
+    } else if (_lcdType == KAV_LCD_GLARESHIELD) {
+        _Glareshield->detach();
+    } else if (_lcdType == HT1621_SEGMENT_LCD) {
+        _SegmentLCD->detach();
     }
 }
 
@@ -168,8 +197,16 @@ void MFCustomDevice::update()
     if (!_initialized) return;
     /* **********************************************************************************
         Do something if required
-        -> Nothing todo for this device
+        -> Only required if HT1621_ASYNC is defined, the displays are written step by step
     ********************************************************************************** */
+    if (_lcdType == KAV_LCD_FCU)
+        _FCU_LCD->update();
+    else if (_lcdType == KAV_LCD_EFIS)
+        _EFIS_LCD->update();
+    else if (_lcdType == KAV_LCD_GLARESHIELD)
+        _Glareshield->update();
+    else if (_lcdType == HT1621_SEGMENT_LCD)
+        _SegmentLCD->update();
 }
 
 /* **********************************************************************************
@@ -181,8 +218,99 @@ void MFCustomDevice::set(int8_t messageID, char *setPoint)
 {
     if (!_initialized) return;
 
+    if (messageID == MESSAGEID_FORCE_REFRESH) {
+        uint8_t displays = (_lcdType == KAV_LCD_GLARESHIELD) ? 3 : 1;
+        _lastValueValid  = 0;
+        cmdMessenger.sendCmdStart(kStatus);
+        cmdMessenger.sendCmdArg(F("Repeated messages dropped"));
+        cmdMessenger.sendCmdArg(_droppedMessages);
+        // the bus statistics of each display, for the glareshield in the order FCU, left EFIS, right EFIS
+        for (uint8_t i = 0; i < displays; i++) {
+            HT1621 *ht;
+            if (_lcdType == KAV_LCD_FCU)
+                ht = _FCU_LCD->getHT1621();
+            else if (_lcdType == KAV_LCD_EFIS)
+                ht = _EFIS_LCD->getHT1621();
+            else if (_lcdType == KAV_LCD_GLARESHIELD)
+                ht = _Glareshield->getHT1621(i);
+            else
+                ht = _SegmentLCD->getHT1621();
+            cmdMessenger.sendCmdArg(F("Bits sent"));
+            cmdMessenger.sendCmdArg(ht->getBitsSent());
+            cmdMessenger.sendCmdArg(F("Frames sent"));
+            cmdMessenger.sendCmdArg(ht->getFramesSent());
+            cmdMessenger.sendCmdArg(F("Bus time us"));
+            cmdMessenger.sendCmdArg(ht->getBusTime());
+        }
+        cmdMessenger.sendCmdEnd();
+        return;
+    }
+    if (isRepeatedMessage(messageID, setPoint)) return;
+
     if (_lcdType == KAV_LCD_FCU)
         _FCU_LCD->set(messageID, setPoint);
     else if (_lcdType == KAV_LCD_EFIS)
         _EFIS_LCD->set(messageID, setPoint);
+    else if (_lcdType == KAV_LCD_GLARESHIELD)
+        _Glareshield->set(messageID, setPoint);
+    else if (_lcdType == HT1621_SEGMENT_LCD)
+        _SegmentLCD->set(messageID, setPoint);
+}
+
+/* **********************************************************************************
+    MobiFlight sends unchanged values quite often, e.g. after a config reload or if
+    a sim variable jitters around the same rounded value. A hash of the last value
+    of each messageID is stored, exact repeats are not forwarded to the device.
+    Special messageIDs (e.g. -1, -2) clear the cache as they change the display,
+    messageIDs beyond the cache are forwarded without changing it.
+    The cache is allocated from the device buffer with 4 bytes per messageID of the
+    device type. If it does not fit, all values are forwarded.
+    If a new value has the same hash as the last one, it is dropped as a repeat.
+    This is unlikely for the short values, but would keep the display unchanged
+    until the next change of this messageID or a Force Refresh.
+********************************************************************************** */
+void MFCustomDevice::allocateCache(uint8_t messages)
+{
+    if (!FitInMemory(messages * sizeof(uint32_t))) {
+        cmdMessenger.sendCmd(kStatus, F("Message cache does not fit in Memory"));
+        return;
+    }
+    _lastValueHash = (uint32_t *)allocateMemory(messages * sizeof(uint32_t));
+    _cacheSize     = messages;
+}
+
+bool MFCustomDevice::isRepeatedMessage(int8_t messageID, const char *setPoint)
+{
+    if (messageID < 0) {
+        _lastValueValid = 0;
+        return false;
+    }
+    if (messageID >= _cacheSize)
+        return false;
+    // FNV-1a, a changed value with the same hash as the last one (about 1 in 2^32) is dropped as well,
+    // the next change or the messageID which clears the cache renders it again
+    uint32_t hash = 2166136261ul;
+    while (*setPoint)
+        hash = (hash ^ (uint8_t)*setPoint++) * 16777619ul;
+
+    if ((_lastValueValid & (1ul << messageID)) && _lastValueHash[messageID] == hash) {
+        _droppedMessages++;
+        return true;
+    }
+    _lastValueHash[messageID] = hash;
+    if (_messageGroups) {
+        // messages of the same group render into the same digits, their cached values are not valid anymore
+        uint8_t group = pgm_read_byte(&_messageGroups[messageID]);
+        for (uint8_t i = 0; group && i < _cacheSize; i++) {
+            if (pgm_read_byte(&_messageGroups[i]) == group)
+                _lastValueValid &= ~(1ul << i);
+        }
+    }
+    _lastValueValid |= 1ul << messageID;
+    return false;
+}
+
+uint16_t MFCustomDevice::getDroppedMessages()
+{
+    return _droppedMessages;
 }
@@ -3,23 +3,39 @@
 #include <Arduino.h>
 #include "KAV_A3XX_FCU_LCD.h"
 #include "KAV_A3XX_EFIS_LCD.h"
+#include "KAV_A3XX_Glareshield.h"
+#include "GenericSegmentLCD.h"
+
+// messageID to clear the same-value cache, afterwards the next value of each messageID is rendered again
+#define MESSAGEID_FORCE_REFRESH 100
 
 enum {
     KAV_LCD_FCU = 1,
-    KAV_LCD_EFIS
+    KAV_LCD_EFIS,
+    KAV_LCD_GLARESHIELD,
+    HT1621_SEGMENT_LCD
 };
 class MFCustomDevice
 {
 public:
     MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrConfig);
-    void detach();
-    void update();
-    void set(int8_t messageID, char *setPoint);
+    void     detach();
+    void     update();
+    void     set(int8_t messageID, char *setPoint);
+    uint16_t getDroppedMessages();
 
 private:
-    bool               getStringFromEEPROM(uint16_t addreeprom, char *buffer);
-    bool               _initialized = false;
-    KAV_A3XX_FCU_LCD  *_FCU_LCD;
-    KAV_A3XX_EFIS_LCD *_EFIS_LCD;
-    uint8_t            _lcdType;
+    bool                  _initialized = false;
+    KAV_A3XX_FCU_LCD     *_FCU_LCD;
+    KAV_A3XX_EFIS_LCD    *_EFIS_LCD;
+    KAV_A3XX_Glareshield *_Glareshield;
+    GenericSegmentLCD    *_SegmentLCD;
+    uint8_t               _lcdType     = 0;
+    void                  allocateCache(uint8_t messages);
+    bool                  isRepeatedMessage(int8_t messageID, const char *setPoint);
+    uint32_t             *_lastValueHash   = nullptr;
+    uint8_t               _cacheSize       = 0;
+    uint32_t              _lastValueValid  = 0;
+    uint16_t              _droppedMessages = 0;
+    const uint8_t        *_messageGroups   = nullptr;
 };
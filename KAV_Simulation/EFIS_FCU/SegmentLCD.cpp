@@ -0,0 +1,129 @@
+#include "SegmentLCD.h"
+
+void SegmentLCD::begin()
+{
+    ht.begin();
+    ht.sendCommand(HT1621::RC256K);
+    ht.sendCommand(HT1621::BIAS_THIRD_4_COM);
+    ht.sendCommand(HT1621::SYS_EN);
+    ht.sendCommand(HT1621::LCD_ON);
+    // This clears the LCD
+    for (uint8_t i = 0; i < ht.MAX_ADDR; i++)
+        ht.write(i, 0);
+
+    // Initialises the buffer to all 0's.
+    memset(buffer, 0, BUFFER_SIZE_MAX);
+}
+
+void SegmentLCD::attach(byte CS, byte CLK, byte DATA)
+{
+    _CS          = CS;
+    _CLK         = CLK;
+    _DATA        = DATA;
+    _initialised = true;
+    begin();
+}
+
+void SegmentLCD::detach()
+{
+    if (!_initialised)
+        return;
+    _initialised = false;
+}
+
+// Copies the buffer into the shadow RAM of the HT1621, only addresses which have changed are sent
+void SegmentLCD::refreshLCD()
+{
+    stageLCD();
+    ht.flush();
+}
+
+void SegmentLCD::stageLCD()
+{
+    for (uint8_t i = 0; i < BUFFER_SIZE_MAX; i++)
+        ht.bufferedWrite(i * 2, buffer[i], 8);
+}
+
+void SegmentLCD::clearLCD()
+{
+    memset(buffer, 0, BUFFER_SIZE_MAX);
+}
+
+void SegmentLCD::update()
+{
+    ht.update();
+}
+
+HT1621 *SegmentLCD::getHT1621()
+{
+    return &ht;
+}
+
+void SegmentLCD::displayDigit(uint8_t address, uint8_t glyph)
+{
+    // anything out of the glyph table is turned to 'blank', as it's unsigned this includes values less than 0
+    if (glyph >= layoutByte(&_layout->glyphCount))
+        glyph = layoutByte(&_layout->blank);
+
+    const uint8_t *glyphs = (const uint8_t *)layoutPointer(&_layout->glyphs);
+    buffer[address]       = (buffer[address] & layoutByte(&_layout->keepMask)) | layoutByte(&glyphs[glyph]);
+}
+
+// removes the glyph, the annunciators at this address are kept
+void SegmentLCD::clearDigit(uint8_t address)
+{
+    buffer[address] &= layoutByte(&_layout->keepMask);
+}
+
+// renders value into the digits, starting with the least significant digit at the highest address
+void SegmentLCD::showNumber(uint8_t address, uint8_t digits, uint32_t value)
+{
+    uint32_t max = 1;
+    for (uint8_t i = 0; i < digits; i++)
+        max *= 10;
+    if (value >= max) value = max - 1;
+
+    for (uint8_t i = digits; i > 0; i--) {
+        displayDigit(address + i - 1, value % 10);
+        value /= 10;
+    }
+}
+
+void SegmentLCD::showValue(uint8_t field, uint32_t value)
+{
+    const SegmentField *fields = (const SegmentField *)layoutPointer(&_layout->fields);
+    showNumber(layoutByte(&fields[field].address), layoutByte(&fields[field].digits), value);
+}
+
+// draws the same glyph into all digits of the field, e.g. dashes
+void SegmentLCD::fillField(uint8_t field, uint8_t glyph)
+{
+    const SegmentField *fields  = (const SegmentField *)layoutPointer(&_layout->fields);
+    uint8_t             address = layoutByte(&fields[field].address);
+
+    for (uint8_t i = 0; i < layoutByte(&fields[field].digits); i++)
+        displayDigit(address + i, glyph);
+}
+
+uint8_t SegmentLCD::fieldAddress(uint8_t field)
+{
+    const SegmentField *fields = (const SegmentField *)layoutPointer(&_layout->fields);
+    return layoutByte(&fields[field].address);
+}
+
+void SegmentLCD::setSegment(uint8_t segment, bool enabled)
+{
+    uint8_t address = segment >> 3;
+    uint8_t bit     = segment & 0x07;
+    buffer[address] = (buffer[address] & ~(1 << bit)) | ((enabled & 1) << bit);
+}
+
+uint8_t SegmentLCD::layoutByte(const uint8_t *address)
+{
+    return _progmem ? pgm_read_byte(address) : *address;
+}
+
+void *SegmentLCD::layoutPointer(const void *address)
+{
+    return _progmem ? (void *)pgm_read_ptr(address) : *(void *const *)address;
+}
@@ -0,0 +1,81 @@
+/**
+ * Segment LCD
+ * Common part of the KAV FCU and EFIS LCD drivers. The digits, glyphs and annunciators of a display
+ * are described by a SegmentLayout in PROGMEM, the engine renders them into a buffer of one byte
+ * per digit which is copied into the shadow RAM of the HT1621.
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "HT1621.h"
+
+#define BUFFER_SIZE_MAX 16
+
+// a single segment which is not part of a glyph, e.g. a label or a decimal point
+#define SEGMENT(address, bit) (((address) << 3) | (bit))
+
+/* **********************************************************************************
+    A numeric field are consecutive digits, the most significant one at the lowest address
+********************************************************************************** */
+struct SegmentField {
+    uint8_t address;
+    uint8_t digits;
+};
+
+/* **********************************************************************************
+    Description of a display, stored in PROGMEM or in RAM if it is built at runtime
+    Each digit is one byte in the buffer. The bits in keepMask are annunciators which
+    are wired to the same address, they are not changed when a glyph is drawn.
+********************************************************************************** */
+struct SegmentLayout {
+    const uint8_t      *glyphs;     // segment pattern of each glyph
+    uint8_t             glyphCount;
+    uint8_t             blank;      // glyph which is drawn for values >= glyphCount
+    uint8_t             keepMask;
+    const SegmentField *fields;
+};
+
+class SegmentLCD
+{
+protected:
+    // Fields
+    HT1621               ht;
+    uint8_t              buffer[BUFFER_SIZE_MAX];
+    const SegmentLayout *_layout;
+    bool                 _progmem;
+    bool                 _initialised;
+    byte                 _CS;
+    byte                 _CLK;
+    byte                 _DATA;
+
+    // Methods
+    void    displayDigit(uint8_t address, uint8_t glyph);
+    void    clearDigit(uint8_t address);
+    void    showNumber(uint8_t address, uint8_t digits, uint32_t value);
+    void    showValue(uint8_t field, uint32_t value);
+    void    fillField(uint8_t field, uint8_t glyph);
+    uint8_t fieldAddress(uint8_t field);
+    void    setSegment(uint8_t segment, bool enabled);
+    uint8_t layoutByte(const uint8_t *address);
+    void   *layoutPointer(const void *address);
+
+public:
+    // Constructor
+    // 'CLK' is sometimes referred to as 'RW'
+    // 'progmem' is false if the layout, the glyphs and the fields are in RAM
+    SegmentLCD(uint8_t CS, uint8_t CLK, uint8_t DATA, const SegmentLayout *layout, bool progmem = true)
+        : ht(CS, CLK, DATA), _layout(layout), _progmem(progmem){};
+
+    void begin();
+    void clearLCD();
+    void attach(byte CS, byte CLK, byte DATA);
+    void detach();
+    void update();
+    // gives access to the bus statistics of the driver
+    HT1621 *getHT1621();
+    // The functions of the drivers only change the buffer, refreshLCD() sends the changes to the display.
+    // stageLCD() only copies them into the shadow RAM of the HT1621, ht.flush() sends them.
+    void refreshLCD();
+    void stageLCD();
+};
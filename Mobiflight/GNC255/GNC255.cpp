@@ -34,14 +34,14 @@ void GNC255::attach()
         Next call the constructor of your custom device
         adapt it to the needs of your constructor
     ********************************************************************************** */
-    if (!FitInMemory(sizeof(U8G2_SSD1322_NHD_256X64_F_4W_SW_SPI))) {
+    if (!FitInMemory(sizeof(GNC255Display))) {
         // Error Message to Connector
         cmdMessenger.sendCmd(kStatus, F("Custom Device does not fit in Memory"));
         return;
     }
 
     //_oledDisplay = new (allocateMemory(sizeof(U8G2_SSD1322_NHD_256X64_F_4W_SW_SPI))) U8G2_SSD1322_NHD_256X64_F_4W_SW_SPI(U8G2_R0, _clk, _data, _cs, _dc);
-    _oledDisplay = new (allocateMemory(sizeof(U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI))) U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI(U8G2_R0, 53, _dc, _reset);
+    _oledDisplay = new (allocateMemory(sizeof(GNC255Display))) GNC255Display(U8G2_R0, 53, _dc, _reset);
     begin();
 }
 
@@ -49,8 +49,9 @@ void GNC255::begin()
 {
     _oledDisplay->begin();
     _oledDisplay->clearBuffer();
+    _markDirty(0, 0, GNC255_TILE_COLUMNS * 8, GNC255_TILE_ROWS * 8);
     _update();
-    _oledDisplay->sendBuffer();
+    _flush();
 }
 
 void GNC255::_update()
@@ -72,8 +73,34 @@ void GNC255::detach()
 
 void GNC255::_stop()
 {
+    activeFrequency[0]  = 0x00;
+    standbyFrequency[0] = 0x00;
+    activeLabel[0]      = 0x00;
+    standbyLabel[0]     = 0x00;
+    _mode               = MODE_NONE;
+    _hasChanged         = true;
     _oledDisplay->clearBuffer();
-    _oledDisplay->sendBuffer();
+    _markDirty(0, 0, GNC255_TILE_COLUMNS * 8, GNC255_TILE_ROWS * 8);
+}
+
+/* **********************************************************************************
+    All changes of one loop() are transferred together. If update() is not called
+    (MF_CUSTOMDEVICE_HAS_UPDATE is not defined), set() transfers them.
+********************************************************************************** */
+void GNC255::update()
+{
+    _flush();
+}
+
+uint16_t GNC255::getFramesSent()
+{
+    return _framesSent;
+}
+
+// Time in us of the last transfer including the rendering in page buffer mode
+uint32_t GNC255::getLastFrameTime()
+{
+    return _lastFrameTime;
 }
 
 void GNC255::set(int8_t messageID, const char *data)
@@ -86,8 +113,10 @@ void GNC255::set(int8_t messageID, const char *data)
     switch (messageID) {
     case -1:
         _stop();
+        break;
     case -2:
         _stop();
+        break;
     case 0:
         break;
     case 1: // set Active Frequency
@@ -108,45 +137,91 @@ void GNC255::set(int8_t messageID, const char *data)
     default:
         break;
     }
-    _oledDisplay->sendBuffer();
+#ifndef MF_CUSTOMDEVICE_HAS_UPDATE
+    _flush();
+#endif
 }
 
 void GNC255::setMode(bool isCom)
 {
+    _mode       = isCom ? MODE_COM : MODE_NAV;
+    _hasChanged = true;
+#if !GNC255_PAGE_BUFFER
     if (isCom) {
-        _renderLabel("   ", ComLayout.ModeNavLabel, OffsetActive, true);
-        _renderLabel("COM", ComLayout.ModeComLabel, OffsetActive, true);
+        _renderLabel("   ", ComLayout.ModeNavLabel, OffsetActive);
+        _renderLabel("COM", ComLayout.ModeComLabel, OffsetActive);
     }
 
     else {
-        _renderLabel("   ", ComLayout.ModeComLabel, OffsetActive, true);
-        _renderLabel("NAV", ComLayout.ModeNavLabel, OffsetActive, true);
+        _renderLabel("   ", ComLayout.ModeComLabel, OffsetActive);
+        _renderLabel("NAV", ComLayout.ModeNavLabel, OffsetActive);
     }
+#endif
 }
 
 void GNC255::updateActiveFreq(const char *frequency)
 {
-    _renderLabel(frequency, ComLayout.Value, OffsetActive);
-    _renderLabel("ACT", ComLayout.ValueLabel, OffsetActive);
+#if GNC255_PAGE_BUFFER
+    _setText(activeFrequency, frequency, sizeof(activeFrequency));
+#else
+    if (_renderFrequency(activeFrequency, frequency, OffsetActive))
+        _renderLabel("ACT", ComLayout.ValueLabel, OffsetActive);
+#endif
 }
 
 void GNC255::updateStandbyFreq(const char *frequency)
 {
-    _renderLabel(frequency, ComLayout.Value, OffsetStandby);
-    _renderLabel("STB", ComLayout.ValueLabel, OffsetStandby);
+#if GNC255_PAGE_BUFFER
+    _setText(standbyFrequency, frequency, sizeof(standbyFrequency));
+#else
+    if (_renderFrequency(standbyFrequency, frequency, OffsetStandby))
+        _renderLabel("STB", ComLayout.ValueLabel, OffsetStandby);
+#endif
 }
 
 void GNC255::updateActiveLabel(const char *frequency)
 {
-    _renderLabel(frequency, ComLayout.Station, OffsetActive);
+    _setText(activeLabel, frequency, sizeof(activeLabel));
+#if !GNC255_PAGE_BUFFER
+    _renderLabel(activeLabel, ComLayout.Station, OffsetActive);
+#endif
 }
 
 void GNC255::updateStandbyLabel(const char *frequency)
 {
-    _renderLabel(frequency, ComLayout.Station, OffsetStandby);
+    _setText(standbyLabel, frequency, sizeof(standbyLabel));
+#if !GNC255_PAGE_BUFFER
+    _renderLabel(standbyLabel, ComLayout.Station, OffsetStandby);
+#endif
 }
 
-void GNC255::_renderLabel(const char *text, Label label, Position offset, bool update)
+void GNC255::_setText(char *dest, const char *text, uint8_t size)
+{
+    strncpy(dest, text, size - 1);
+    dest[size - 1] = 0x00;
+    _hasChanged    = true;
+}
+
+// Renders the complete layout from the stored texts, used for each page in page buffer mode
+void GNC255::_drawPage()
+{
+    if (activeFrequency[0]) {
+        _renderLabel(activeFrequency, ComLayout.Value, OffsetActive);
+        _renderLabel("ACT", ComLayout.ValueLabel, OffsetActive);
+    }
+    if (standbyFrequency[0]) {
+        _renderLabel(standbyFrequency, ComLayout.Value, OffsetStandby);
+        _renderLabel("STB", ComLayout.ValueLabel, OffsetStandby);
+    }
+    _renderLabel(activeLabel, ComLayout.Station, OffsetActive);
+    _renderLabel(standbyLabel, ComLayout.Station, OffsetStandby);
+    if (_mode == MODE_COM)
+        _renderLabel("COM", ComLayout.ModeComLabel, OffsetActive);
+    else if (_mode == MODE_NAV)
+        _renderLabel("NAV", ComLayout.ModeNavLabel, OffsetActive);
+}
+
+void GNC255::_renderLabel(const char *text, Label label, Position offset)
 {
     _oledDisplay->setFont(label.Font);
     u8g2_int_t w = _oledDisplay->getStrWidth(text);
@@ -158,5 +233,137 @@ void GNC255::_renderLabel(const char *text, Label label, Position offset, bool u
     _oledDisplay->setCursor(offset.x + label.Pos.x, offset.y + label.Pos.y);
 
     _oledDisplay->print(text);
-    if (update) _oledDisplay->sendBuffer();
-}
\ No newline at end of file
+
+    // the glyphs could be higher than the cleared box and descenders are below the baseline
+    u8g2_int_t top    = max(h, (u8g2_int_t)_oledDisplay->getAscent());
+    u8g2_int_t bottom = -_oledDisplay->getDescent();
+    _markDirty(offset.x + label.Pos.x, offset.y + label.Pos.y - top, w, top + bottom);
+}
+
+/* **********************************************************************************
+    Only the glyphs which differ from the current text are cleared and drawn again.
+    As long as the changed glyphs have the same width, the position of the following
+    ones does not change. Otherwise the rest of the text is drawn again.
+    Returns true if the first glyph was drawn, as it overlaps the value label.
+********************************************************************************** */
+bool GNC255::_renderFrequency(char *current, const char *text, Position offset)
+{
+    Label   label = ComLayout.Value;
+    u8g2_t *u8g2  = _oledDisplay->getU8g2();
+    uint8_t size  = sizeof(activeFrequency) - 1;
+    uint8_t i     = 0;
+
+    _oledDisplay->setFont(label.Font);
+    u8g2_int_t x      = offset.x + label.Pos.x;
+    u8g2_int_t y      = offset.y + label.Pos.y;
+    u8g2_int_t h      = label.FontSize;
+    u8g2_int_t top    = max(h, (u8g2_int_t)_oledDisplay->getAscent());
+    u8g2_int_t bottom = -_oledDisplay->getDescent();
+    _oledDisplay->setFontMode(0);
+
+    for (; i < size && text[i] && current[i] == text[i]; i++)
+        x += u8g2_GetGlyphWidth(u8g2, current[i]);
+    if (i == size || current[i] == text[i])
+        return false;
+    bool firstGlyph = i == 0;
+
+    for (; i < size && text[i] && current[i]; i++) {
+        u8g2_int_t w = u8g2_GetGlyphWidth(u8g2, text[i]);
+        if (w != u8g2_GetGlyphWidth(u8g2, current[i]))
+            break;
+        if (current[i] != text[i]) {
+            _oledDisplay->setDrawColor(0);
+            _oledDisplay->drawBox(x, y - h, w, h);
+            _oledDisplay->setDrawColor(1);
+            _oledDisplay->drawGlyph(x, y, text[i]);
+            _markDirty(x, y - top, w, top + bottom);
+            current[i] = text[i];
+        }
+        x += w;
+    }
+
+    if (i < size && (text[i] || current[i])) {
+        u8g2_int_t w = 0, wOld = 0;
+        for (uint8_t j = i; j < size && text[j]; j++)
+            w += u8g2_GetGlyphWidth(u8g2, text[j]);
+        for (uint8_t j = i; j < size && current[j]; j++)
+            wOld += u8g2_GetGlyphWidth(u8g2, current[j]);
+        w = max(w, wOld);
+        _oledDisplay->setDrawColor(0);
+        _oledDisplay->drawBox(x, y - h, w, h);
+        _oledDisplay->setDrawColor(1);
+        _markDirty(x, y - top, w, top + bottom);
+        for (; i < size && text[i]; i++) {
+            x += _oledDisplay->drawGlyph(x, y, text[i]);
+            current[i] = text[i];
+        }
+        current[i] = 0x00;
+    }
+    return firstGlyph;
+}
+
+void GNC255::_markDirty(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    int16_t firstColumn = max(x, 0) / 8;
+    int16_t lastColumn  = min(x + w - 1, GNC255_TILE_COLUMNS * 8 - 1) / 8;
+    int16_t firstRow    = max(y, 0) / 8;
+    int16_t lastRow     = min(y + h - 1, GNC255_TILE_ROWS * 8 - 1) / 8;
+    if (firstColumn > lastColumn || firstRow > lastRow)
+        return;
+
+    uint32_t columns = (0xFFFFFFFFul >> (31 - (lastColumn - firstColumn))) << firstColumn;
+    for (int16_t row = firstRow; row <= lastRow; row++)
+        _dirtyTiles[row] |= columns;
+}
+
+// This is the only place where the display buffer is transferred. Only the tiles
+// which have changed since the last transfer are sent, or the complete buffer if all have changed.
+// In page buffer mode the layout is rendered page by page and the complete frame is sent.
+void GNC255::_flush()
+{
+#if GNC255_PAGE_BUFFER
+    if (!_hasChanged)
+        return;
+    _hasChanged         = false;
+    uint32_t frameStart = micros();
+    _oledDisplay->firstPage();
+    do {
+        _drawPage();
+    } while (_oledDisplay->nextPage());
+    _lastFrameTime = micros() - frameStart;
+    _framesSent++;
+#else
+    bool allDirty = true;
+    bool anyDirty = false;
+    for (uint8_t row = 0; row < GNC255_TILE_ROWS; row++) {
+        allDirty &= _dirtyTiles[row] == 0xFFFFFFFF;
+        anyDirty |= _dirtyTiles[row] != 0;
+    }
+    if (!anyDirty)
+        return;
+    _framesSent++;
+
+    if (allDirty) {
+        _oledDisplay->sendBuffer();
+        memset(_dirtyTiles, 0, sizeof(_dirtyTiles));
+        return;
+    }
+
+    for (uint8_t row = 0; row < GNC255_TILE_ROWS; row++) {
+        uint8_t column = 0;
+        while (_dirtyTiles[row]) {
+            while (!(_dirtyTiles[row] & (1ul << column)))
+                column++;
+            uint8_t width = 0;
+            while (column + width < GNC255_TILE_COLUMNS && (_dirtyTiles[row] & (1ul << (column + width)))) {
+                _dirtyTiles[row] &= ~(1ul << (column + width));
+                width++;
+            }
+            _oledDisplay->updateDisplayArea(column, row, width, 1);
+            column += width;
+        }
+    }
+#endif
+}
@@ -20,6 +20,31 @@ struct Label {
     const Position Pos;
 };
 
+// the display is transferred in tiles of 8x8 pixel
+#define GNC255_TILE_COLUMNS 32
+#define GNC255_TILE_ROWS    8
+// max. characters of the station labels
+#define GNC255_LABEL_LENGTH 10
+// number of messageIDs, starting from 0
+#define GNC255_MESSAGES     6
+
+/* **********************************************************************************
+    Define GNC255_PAGE_BUFFER=1 or GNC255_PAGE_BUFFER=2 to use a page buffer of one or
+    two tile rows (256 or 512 bytes) instead of the full frame buffer (2048 bytes, also
+    with GNC255_PAGE_BUFFER=0).
+    In page buffer mode the complete layout is rendered from the stored texts for
+    each page and the complete frame is transferred on every change.
+********************************************************************************** */
+#if GNC255_PAGE_BUFFER == 1
+typedef U8G2_SSD1322_NHD_256X64_1_4W_HW_SPI GNC255Display;
+#elif GNC255_PAGE_BUFFER == 2
+typedef U8G2_SSD1322_NHD_256X64_2_4W_HW_SPI GNC255Display;
+#elif GNC255_PAGE_BUFFER
+#error "GNC255_PAGE_BUFFER must be 0, 1 or 2"
+#else
+typedef U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI GNC255Display;
+#endif
+
 struct Layout {
     Label Value;
     Label ValueLabel;
@@ -31,19 +56,35 @@ class GNC255
 {
 public:
     GNC255(uint8_t clk, uint8_t data, uint8_t cs, uint8_t dc, uint8_t reset);
-    void begin();
-    void attach();
-    void detach();
-    void set(int8_t messageID, const char *setPoint);
+    void     begin();
+    void     attach();
+    void     detach();
+    void     set(int8_t messageID, const char *setPoint);
+    void     update();
+    uint16_t getFramesSent();
+    uint32_t getLastFrameTime();
 
 private:
+    enum Modes : uint8_t {
+        MODE_NONE,
+        MODE_COM,
+        MODE_NAV
+    };
+
     // U8G2_SSD1322_NHD_256X64_F_4W_SW_SPI *_oledDisplay;
-    U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI *_oledDisplay;
-    bool                                 _initialised;
-    uint8_t                              _clk, _data, _cs, _dc, _reset;
-    bool                                 _hasChanged;
-    char                                 activeFrequency[8]  = "123.456";
-    char                                 standbyFrequency[8] = "123.456";
+    GNC255Display *_oledDisplay;
+    bool           _initialised;
+    uint8_t        _clk, _data, _cs, _dc, _reset;
+    bool           _hasChanged = false;
+    // the texts which are shown on the display, the frequencies are compared against them
+    char           activeFrequency[8]                      = "";
+    char           standbyFrequency[8]                     = "";
+    char           activeLabel[GNC255_LABEL_LENGTH + 1]    = "";
+    char           standbyLabel[GNC255_LABEL_LENGTH + 1]   = "";
+    uint8_t        _mode                                   = MODE_NONE;
+    uint32_t       _dirtyTiles[GNC255_TILE_ROWS]           = {0}; // one bit per tile column
+    uint16_t       _framesSent                             = 0;
+    uint32_t       _lastFrameTime                          = 0;
 
     void _update();
     void _stop();
@@ -52,5 +93,10 @@ private:
     void updateStandbyFreq(const char *frequency);
     void updateActiveLabel(const char *frequency);
     void updateStandbyLabel(const char *frequency);
-    void _renderLabel(const char *text, Label label, Position offset, bool update = false);
+    void _setText(char *dest, const char *text, uint8_t size);
+    void _drawPage();
+    void _renderLabel(const char *text, Label label, Position offset);
+    bool _renderFrequency(char *current, const char *text, Position offset);
+    void _markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+    void _flush();
 };
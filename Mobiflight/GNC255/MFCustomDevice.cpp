@@ -1,42 +1,15 @@
 #include "MFCustomDevice.h"
 #include "commandmessenger.h"
 #include "allocateMem.h"
-#include "MFEEPROM.h"
-
-extern MFEEPROM MFeeprom;
+#include "../../_common/CustomDeviceConfig.h"
 
 /* **********************************************************************************
     The custom device pins, type and configuration is stored in the EEPROM
     While loading the config the adresses in the EEPROM are transferred to the constructor
-    Within the constructor you have to copy the EEPROM content to a buffer
-    and evaluate him. The buffer is used for all 3 types (pins, type configuration),
-    so do it step by step.
-    The max size of the buffer is defined here. It must be the size of the
-    expected max length of these strings.
-    E.g. 6 pins are required, each pin could have two characters (two digits),
-    each pins are delimited by "|" and the string is NULL terminated.
-    -> (6 * 2) + 5 + 1 = 18 bytes is the maximum.
-    The custom type is "MyCustomDevice", which means 14 characters plus NULL = 15
-    The configuration is "myConfig", which means 8 characters plus NULL = 9
-    The maximum characters to be expected is 18, so MEMLEN_STRING_BUFFER has to be at least 18
+    They are read with the helpers in _common/CustomDeviceConfig.h
 ********************************************************************************** */
-#define MEMLEN_STRING_BUFFER 40
 
-// reads a string from EEPROM at given address which is '.' terminated and saves it to the buffer
-bool MFCustomDevice::getStringFromEEPROM(uint16_t addreeprom, char *buffer)
-{
-    char    temp    = 0;
-    uint8_t counter = 0;
-    do {
-        temp              = MFeeprom.read_byte((addreeprom)++); // read the first character
-        buffer[counter++] = temp;                               // save character and locate next buffer position
-        if (counter >= MEMLEN_STRING_BUFFER) {                  // nameBuffer will be exceeded
-            return false;                                       // abort copying to buffer
-        }
-    } while (temp != '.');      // reads until limiter '.' and locates the next free buffer position
-    buffer[counter - 1] = 0x00; // replace '.' by NULL, terminates the string
-    return true;
-}
+static const char GNC255Name[] PROGMEM = "MOBIFLIGHT_GNC255";
 
 /* **********************************************************************************
     Within the connector pins, a device name and a config string can be defined
@@ -53,17 +26,13 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
         Do something which is required to setup your custom device
     ********************************************************************************** */
 
-    char   *params, *p = NULL;
-    char    parameter[MEMLEN_STRING_BUFFER];
-    uint8_t _clk, _data, _cs, _dc, _reset;
+    uint8_t pins[5];
 
     /* **********************************************************************************************
-        Read the Type from the EEPROM, copy it into a buffer and evaluate it.
-        The string get's NOT stored as this would need a lot of RAM, instead a variable
-        is used to store the type
+        Compare the Type in the EEPROM with the supported type
+        The string get's NOT stored as this would need a lot of RAM
     ********************************************************************************************** */
-    getStringFromEEPROM(adrType, parameter);
-    if (strcmp(parameter, "MOBIFLIGHT_GNC255") == 1) {
+    if (!CustomDeviceConfig::compareStringFromEEPROM(adrType, GNC255Name)) {
         cmdMessenger.sendCmd(kStatus, F("Custom Device is not supported by this firmware version"));
         return;
     }
@@ -77,31 +46,18 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
         return;
     }
     /* **********************************************************************************************
-        Read the pins from the EEPROM, copy them into a buffer
-        If you have set '"isI2C": true' in the device.json file, the first value is the I2C address
+        read the pins from the EEPROM and split them up into single pins
+        CLK|Data|CS|DC|Reset
     ********************************************************************************************** */
-    getStringFromEEPROM(adrPin, parameter);
-    /* **********************************************************************************************
-        Split the pins up into single pins. As the number of pins could be different between
-        multiple devices, it is done here.
-    ********************************************************************************************** */
-    params = strtok_r(parameter, "|", &p);
-    _clk   = atoi(params);
-    params = strtok_r(NULL, "|", &p);
-    _data  = atoi(params);
-    params = strtok_r(NULL, "|", &p);
-    _cs    = atoi(params);
-    params = strtok_r(NULL, "|", &p);
-    _dc    = atoi(params);
-    params = strtok_r(NULL, "|", &p);
-    _reset = atoi(params);
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 5);
 
     /* **********************************************************************************
         Next call the constructor of your custom device
         adapt it to the needs of your constructor
     ********************************************************************************** */
-    _mydevice = new (allocateMemory(sizeof(GNC255))) GNC255(_clk, _data, _cs, _dc, _reset);
+    _mydevice = new (allocateMemory(sizeof(GNC255))) GNC255(pins[0], pins[1], pins[2], pins[3], pins[4]);
     _mydevice->attach();
+    allocateCache(GNC255_MESSAGES);
 
     _initialized = true;
 }
@@ -131,7 +87,9 @@ void MFCustomDevice::update()
     if (!_initialized) return;
     /* **********************************************************************************
         Do something if required
+        -> Transfer the changes of the display
     ********************************************************************************** */
+    _mydevice->update();
 }
 
 /* **********************************************************************************
@@ -139,9 +97,71 @@ void MFCustomDevice::update()
     this function gets called when a new value is available.
     It gets called from CustomerDevice::OnSet()
 ********************************************************************************** */
-void MFCustomDevice::set(uint8_t messageID, char *setPoint)
+void MFCustomDevice::set(int8_t messageID, char *setPoint)
 {
     if (!_initialized) return;
 
+    if (messageID == MESSAGEID_FORCE_REFRESH) {
+        _lastValueValid = 0;
+        cmdMessenger.sendCmdStart(kStatus);
+        cmdMessenger.sendCmdArg(F("Repeated messages dropped"));
+        cmdMessenger.sendCmdArg(_droppedMessages);
+        cmdMessenger.sendCmdArg(F("Frames sent"));
+        cmdMessenger.sendCmdArg(_mydevice->getFramesSent());
+        cmdMessenger.sendCmdArg(F("Last frame us"));
+        cmdMessenger.sendCmdArg(_mydevice->getLastFrameTime());
+        cmdMessenger.sendCmdEnd();
+        return;
+    }
+    if (isRepeatedMessage(messageID, setPoint)) return;
+
     _mydevice->set(messageID, setPoint);
-}
\ No newline at end of file
+}
+
+/* **********************************************************************************
+    MobiFlight sends unchanged values quite often, e.g. after a config reload or if
+    a sim variable jitters around the same rounded value. A hash of the last value
+    of each messageID is stored, exact repeats are not forwarded to the device.
+    Special messageIDs (e.g. -1, -2) clear the cache as they change the display,
+    messageIDs beyond the cache are forwarded without changing it.
+    The cache is allocated from the device buffer with 4 bytes per messageID.
+    If it does not fit, all values are forwarded.
+********************************************************************************** */
+void MFCustomDevice::allocateCache(uint8_t messages)
+{
+    if (!FitInMemory(messages * sizeof(uint32_t))) {
+        cmdMessenger.sendCmd(kStatus, F("Message cache does not fit in Memory"));
+        return;
+    }
+    _lastValueHash = (uint32_t *)allocateMemory(messages * sizeof(uint32_t));
+    _cacheSize     = messages;
+}
+
+bool MFCustomDevice::isRepeatedMessage(int8_t messageID, const char *setPoint)
+{
+    if (messageID < 0) {
+        _lastValueValid = 0;
+        return false;
+    }
+    if (messageID >= _cacheSize)
+        return false;
+    // FNV-1a, a changed value with the same hash as the last one (about 1 in 2^32) is dropped as well,
+    // the next change or the messageID which clears the cache renders it again
+    uint32_t hash = 2166136261ul;
+    while (*setPoint)
+        hash = (hash ^ (uint8_t)*setPoint++) * 16777619ul;
+
+    if ((_lastValueValid & (1ul << messageID)) && _lastValueHash[messageID] == hash) {
+        _droppedMessages++;
+        return true;
+    }
+    // each messageID renders into its own area of the display, so no other cached value gets invalid
+    _lastValueHash[messageID] = hash;
+    _lastValueValid |= 1ul << messageID;
+    return false;
+}
+
+uint16_t MFCustomDevice::getDroppedMessages()
+{
+    return _droppedMessages;
+}
@@ -3,16 +3,25 @@
 #include <Arduino.h>
 #include "GNC255.h"
 
+// messageID to clear the same-value cache, afterwards the next value of each messageID is rendered again
+#define MESSAGEID_FORCE_REFRESH 100
+
 class MFCustomDevice
 {
 public:
     MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrConfig);
-    void detach();
-    void update();
-    void set(uint8_t messageID, char *setPoint);
+    void     detach();
+    void     update();
+    void     set(int8_t messageID, char *setPoint);
+    uint16_t getDroppedMessages();
 
 private:
-    bool    getStringFromEEPROM(uint16_t addreeprom, char *buffer);
-    bool    _initialized = false;
-    GNC255 *_mydevice;
+    bool      _initialized = false;
+    GNC255   *_mydevice;
+    void      allocateCache(uint8_t messages);
+    bool      isRepeatedMessage(int8_t messageID, const char *setPoint);
+    uint32_t *_lastValueHash   = nullptr;
+    uint8_t   _cacheSize       = 0;
+    uint32_t  _lastValueValid  = 0;
+    uint16_t  _droppedMessages = 0;
 };
\ No newline at end of file
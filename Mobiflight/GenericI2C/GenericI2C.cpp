@@ -1,8 +1,24 @@
 #include "GenericI2C.h"
 #include "allocateMem.h"
 #include "commandmessenger.h"
+#include "../../_common/CustomDeviceConfig.h"
 #include <Wire.h>
 
+// the size of the transmit buffer of the Wire library
+#if defined(BUFFER_LENGTH)
+#define GENERICI2C_TX_BUFFER BUFFER_LENGTH
+#elif defined(WIRE_BUFFER_SIZE)
+#define GENERICI2C_TX_BUFFER WIRE_BUFFER_SIZE
+#else
+#define GENERICI2C_TX_BUFFER 32
+#endif
+
+// binary frame: messageID, type|more|chunk, length, payload, CRC-8
+#define GENERICI2C_FRAME_OVERHEAD 4
+#define GENERICI2C_MAX_PAYLOAD    (GENERICI2C_TX_BUFFER - GENERICI2C_FRAME_OVERHEAD)
+#define GENERICI2C_FLAG_MORE      0x10
+#define GENERICI2C_MAX_CHUNKS     16
+
 /* **********************************************************************************
     This is just the basic code to set up your custom device.
     Change/add your code as needed.
@@ -10,7 +26,7 @@
 
 GenericI2C::GenericI2C(uint8_t addrI2C)
 {
-    _addrI2C = addrI2C;
+    _addrI2C[0] = addrI2C;
     _initialised = true;
 }
 
@@ -18,6 +34,9 @@ void GenericI2C::begin()
 {
     Wire.begin();
     Wire.setClock(400000);
+#ifdef WIRE_HAS_TIMEOUT
+    Wire.setWireTimeout(GENERICI2C_WIRE_TIMEOUT_US, true);
+#endif
 }
 
 void GenericI2C::attach()
@@ -28,6 +47,7 @@ void GenericI2C::detach()
 {
     if (!_initialised)
         return;
+    _queueCount  = 0;
     _initialised = false;
 }
 
@@ -42,13 +62,417 @@ void GenericI2C::set(int8_t messageID, char *setPoint)
         MessageID == -2 will be send from the connector when PowerSavingMode is entered
         Put in your code to enter this mode (e.g. clear a display)
     ********************************************************************************** */
-    Wire.beginTransmission(_addrI2C);
-    Wire.write(messageID);
-    Wire.print(setPoint);
-    Wire.endTransmission();
+    if (messageID == GENERICI2C_MESSAGEID_DIAGNOSTICS) {
+        _reportStatistics();
+        return;
+    }
+    if (_queued && _enqueue(messageID, setPoint))
+        return;
+    _send(messageID, setPoint);
+}
+
+void GenericI2C::setProtocol(uint8_t protocol)
+{
+    _protocol = protocol;
+}
+
+// The queue is only sent from update(), so it can't be used if update() is not called
+void GenericI2C::setQueued(bool queued)
+{
+#ifdef MF_CUSTOMDEVICE_HAS_UPDATE
+    _queued = queued && _allocateQueue();
+#endif
+}
+
+/* **********************************************************************************
+    A failed transmission is repeated up to retries times to the slaves which failed.
+    The wait time before a retry doubles with each retry, up to GENERICI2C_MAX_BACKOFF_US.
+    The value waits in the queue meanwhile and update() sends it, so nothing is blocked.
+    Without update() or if the value does not fit into the queue, it is repeated at once.
+********************************************************************************** */
+void GenericI2C::setRetries(uint8_t retries, uint16_t backoffUs)
+{
+    _retries   = min(retries, (uint8_t)GENERICI2C_MAX_RETRIES);
+    _backoffUs = backoffUs;
+#ifdef MF_CUSTOMDEVICE_HAS_UPDATE
+    if (_retries)
+        _allocateQueue();
+#endif
+}
+
+/* **********************************************************************************
+    Further slaves which get the same values as the first one. The addresses are
+    separated by '+', a range is given by '-', e.g. "0x21+0x22" or "0x21-0x24".
+    Decimal and hex (0x..) addresses are accepted like for the pins.
+    A list with an invalid address (above 0x7F), a reversed range or more than
+    GENERICI2C_MAX_ADDRESSES slaves is rejected as a whole with an error message.
+********************************************************************************** */
+void GenericI2C::addAddresses(const char *list)
+{
+    const char   *end;
+    unsigned long first, last;
+    uint8_t       count = _addrCount;
+
+    while (*list) {
+        first = last = CustomDeviceConfig::parseNumber(list, &end);
+        if (end != list && *end == '-') {
+            list = end + 1;
+            last = CustomDeviceConfig::parseNumber(list, &end);
+        }
+        if (end == list || last > 0x7F || first > last || count + (last - first) >= GENERICI2C_MAX_ADDRESSES ||
+            (*end != '+' && *end != 0x00)) {
+            cmdMessenger.sendCmd(kStatus, F("I2C address list is not valid"));
+            return;
+        }
+        for (uint8_t address = first; address <= last; address++)
+            _addrI2C[count++] = address;
+        list = *end == '+' ? end + 1 : end;
+    }
+    _addrCount = count;
+}
+
+// All slaves get the values with one transmission to the general call address instead of one per slave
+void GenericI2C::setBroadcast(bool broadcast)
+{
+    _broadcast = broadcast;
+}
+
+// The queue is allocated once from the device buffer, returns false if it does not fit
+bool GenericI2C::_allocateQueue()
+{
+    if (_queue)
+        return true;
+    if (!FitInMemory(GENERICI2C_QUEUE_SIZE * sizeof(QueueEntry))) {
+        cmdMessenger.sendCmd(kStatus, F("I2C queue does not fit in Memory"));
+        return false;
+    }
+    _queue = (QueueEntry *)allocateMemory(GENERICI2C_QUEUE_SIZE * sizeof(QueueEntry));
+    return true;
+}
+
+/* **********************************************************************************
+    A new value of a queued messageID replaces the old one at the same position,
+    so the order of the messageIDs is kept, a pending retry of the old value is dropped.
+    Returns false if the value has to be sent directly.
+********************************************************************************** */
+bool GenericI2C::_enqueue(int8_t messageID, const char *setPoint)
+{
+    uint8_t i = 0;
+
+    while (i < _queueCount && _queue[i].messageID != messageID)
+        i++;
+    if (strlen(setPoint) > GENERICI2C_QUEUE_VALUE_LENGTH || i == GENERICI2C_QUEUE_SIZE)
+        return false;
+    if (i == _queueCount)
+        _queueCount++;
+    _queue[i].messageID = messageID;
+    _queue[i].attempt   = 0;
+    _queue[i].targets   = _allTargets();
+    strcpy(_queue[i].value, setPoint);
+    return true;
+}
+
+void GenericI2C::_dequeue(uint8_t index)
+{
+    memmove(&_queue[index], &_queue[index + 1], (_queueCount - index - 1) * sizeof(QueueEntry));
+    _queueCount--;
+}
+
+// Schedules the next retry of a queued value, returns false if all retries are used up
+bool GenericI2C::_retryLater(uint8_t index, uint8_t failed)
+{
+    QueueEntry *entry = &_queue[index];
+
+    if (entry->attempt++ == _retries)
+        return false;
+    entry->targets   = failed;
+    entry->retryAtUs = micros() + min((uint32_t)_backoffUs << (entry->attempt - 1), (uint32_t)GENERICI2C_MAX_BACKOFF_US);
+    _stats.retries++;
+    return true;
+}
+
+// one bit per slave, the broadcast is sent once
+uint8_t GenericI2C::_allTargets()
+{
+    return _broadcast ? 1 : (1u << _addrCount) - 1;
+}
+
+/* **********************************************************************************
+    Sends a value directly. A queued older value of this messageID is dropped before,
+    so a pending retry can't overwrite the new value.
+    If the transmission fails, the value is queued for a retry, see setRetries().
+********************************************************************************** */
+void GenericI2C::_send(int8_t messageID, const char *setPoint)
+{
+    uint8_t targets = _allTargets();
+
+    for (uint8_t i = 0; i < _queueCount; i++) {
+        if (_queue[i].messageID == messageID) {
+            _dequeue(i);
+            break;
+        }
+    }
+    for (uint8_t attempt = 0;; attempt++) {
+        if (_protocol == GENERICI2C_PROTOCOL_BINARY)
+            targets = _sendBinary(messageID, setPoint, targets);
+        else
+            targets = _sendText(messageID, setPoint, targets);
+        if (targets == 0 || attempt == _retries)
+            return;
+#ifdef MF_CUSTOMDEVICE_HAS_UPDATE
+        if (_queue && strlen(setPoint) <= GENERICI2C_QUEUE_VALUE_LENGTH && _queueCount < GENERICI2C_QUEUE_SIZE) {
+            _queue[_queueCount].messageID = messageID;
+            _queue[_queueCount].attempt   = 0;
+            strcpy(_queue[_queueCount].value, setPoint);
+            _retryLater(_queueCount++, targets);
+            return;
+        }
+#endif
+        _stats.retries++;
+    }
+}
+
+// Like before the text gets truncated if it does not fit into the transmit buffer
+// Returns the slaves which did not get it
+uint8_t GenericI2C::_sendText(int8_t messageID, const char *setPoint, uint8_t targets)
+{
+    uint8_t buffer[GENERICI2C_TX_BUFFER];
+    uint8_t len = min(strlen(setPoint), (size_t)GENERICI2C_TX_BUFFER - 1);
+
+    buffer[0] = messageID;
+    memcpy(&buffer[1], setPoint, len);
+    return _transmit(buffer, len + 1, targets);
 }
 
+/* **********************************************************************************
+    Each frame consists of:
+    byte 0:     messageID
+    byte 1:     bit 7..5 payload type, bit 4 more chunks follow, bit 3..0 chunk number
+    byte 2:     length of the payload
+    byte 3..n:  payload, numbers are little endian
+    byte n+1:   CRC-8 (polynom 0x07, init 0x00) over all bytes before
+    Texts which do not fit into one transmission are split up into up to 16 chunks.
+    Returns the slaves which did not get all chunks, they get no further chunks.
+********************************************************************************** */
+uint8_t GenericI2C::_sendBinary(int8_t messageID, const char *setPoint, uint8_t targets)
+{
+    uint8_t        frame[GENERICI2C_TX_BUFFER];
+    uint8_t        number[5];
+    uint8_t        len;
+    uint8_t        type    = _encode(setPoint, number, &len);
+    const uint8_t *payload = number;
+    uint16_t       remaining;
+    uint8_t        chunk  = 0;
+    uint8_t        failed = 0;
+
+    if (type == PAYLOAD_TEXT) {
+        payload   = (const uint8_t *)setPoint;
+        remaining = min(strlen(setPoint), (size_t)GENERICI2C_MAX_PAYLOAD * GENERICI2C_MAX_CHUNKS);
+    } else {
+        remaining = len;
+    }
+
+    do {
+        len = min(remaining, (uint16_t)GENERICI2C_MAX_PAYLOAD);
+        remaining -= len;
+        failed |= _transmit(frame, _buildFrame(frame, messageID, (type << 5) | (remaining ? GENERICI2C_FLAG_MORE : 0) | chunk, payload, len), targets & ~failed);
+        payload += len;
+        chunk++;
+    } while (remaining);
+    return failed;
+}
+
+uint8_t GenericI2C::_buildFrame(uint8_t *frame, int8_t messageID, uint8_t flags, const uint8_t *payload, uint8_t len)
+{
+    frame[0] = messageID;
+    frame[1] = flags;
+    frame[2] = len;
+    memcpy(&frame[3], payload, len);
+    frame[3 + len] = _crc8(frame, 3 + len);
+    return len + GENERICI2C_FRAME_OVERHEAD;
+}
+
+/* **********************************************************************************
+    All transmissions are done here, so the statistics cover everything.
+    Each slave in targets (one bit per slave) gets its own transaction, except for
+    broadcast. Returns the slaves for which the transaction failed.
+    Result of endTransmission(): 0 success, 2/3 NACK on address/data,
+    5 timeout (if supported by the Wire library), 1/4 other errors
+********************************************************************************** */
+uint8_t GenericI2C::_transmit(const uint8_t *data, uint8_t len, uint8_t targets)
+{
+    uint8_t failed = 0;
+
+    if (_broadcast) {
+        if (targets && !_transmitTo(GENERICI2C_BROADCAST_ADDRESS, data, len))
+            failed = 1;
+        return failed;
+    }
+    for (uint8_t i = 0; i < _addrCount; i++) {
+        if ((targets & (1 << i)) && !_transmitTo(_addrI2C[i], data, len))
+            failed |= 1 << i;
+    }
+    return failed;
+}
+
+bool GenericI2C::_transmitTo(uint8_t address, const uint8_t *data, uint8_t len)
+{
+    uint32_t start = micros();
+    uint8_t  result;
+
+    Wire.beginTransmission(address);
+    Wire.write(data, len);
+    result = Wire.endTransmission();
+    if (result == 0)
+        _stats.bytes += len;
+    else if (result == 2 || result == 3)
+        _stats.nacks++;
+    else if (result == 5)
+        _stats.timeouts++;
+    else
+        _stats.errors++;
+
+    uint32_t duration = micros() - start;
+    _stats.transactions++;
+    _stats.totalUs += duration;
+    if (duration < _stats.minUs)
+        _stats.minUs = duration;
+    if (duration > _stats.maxUs)
+        _stats.maxUs = duration;
+    return result == 0;
+}
+
+void GenericI2C::_reportStatistics()
+{
+    cmdMessenger.sendCmdStart(kStatus);
+    cmdMessenger.sendCmdArg(F("I2C address"));
+    cmdMessenger.sendCmdArg(_broadcast ? GENERICI2C_BROADCAST_ADDRESS : _addrI2C[0]);
+    cmdMessenger.sendCmdArg(F("Slaves"));
+    cmdMessenger.sendCmdArg(_addrCount);
+    cmdMessenger.sendCmdArg(F("Transactions"));
+    cmdMessenger.sendCmdArg(_stats.transactions);
+    cmdMessenger.sendCmdArg(F("Bytes"));
+    cmdMessenger.sendCmdArg(_stats.bytes);
+    cmdMessenger.sendCmdArg(F("NACKs"));
+    cmdMessenger.sendCmdArg(_stats.nacks);
+    cmdMessenger.sendCmdArg(F("Timeouts"));
+    cmdMessenger.sendCmdArg(_stats.timeouts);
+    cmdMessenger.sendCmdArg(F("Errors"));
+    cmdMessenger.sendCmdArg(_stats.errors);
+    cmdMessenger.sendCmdArg(F("Retries"));
+    cmdMessenger.sendCmdArg(_stats.retries);
+    cmdMessenger.sendCmdArg(F("Time us min/avg/max"));
+    cmdMessenger.sendCmdArg(_stats.transactions ? _stats.minUs : 0);
+    cmdMessenger.sendCmdArg(_stats.transactions ? _stats.totalUs / _stats.transactions : 0);
+    cmdMessenger.sendCmdArg(_stats.maxUs);
+    cmdMessenger.sendCmdEnd();
+}
+
+/* **********************************************************************************
+    Converts plain numbers into the smallest numeric payload, the number of decimals
+    is kept for fixed point values. Everything else, and numbers with leading zeros
+    which would get lost, is sent as text.
+********************************************************************************** */
+uint8_t GenericI2C::_encode(const char *setPoint, uint8_t *payload, uint8_t *len)
+{
+    const char *c        = setPoint;
+    bool        negative = *c == '-';
+    uint32_t    limit    = negative ? 0x80000000ul : 0x7FFFFFFFul;
+    uint32_t    value    = 0;
+    uint8_t     decimals = 0;
+    bool        point    = false;
+
+    if (negative)
+        c++;
+    if (!isDigit(*c) || (c[0] == '0' && isDigit(c[1])))
+        return PAYLOAD_TEXT;
+    for (; *c; c++) {
+        if (*c == '.' && !point && isDigit(c[1])) {
+            point = true;
+            continue;
+        }
+        if (!isDigit(*c) || value > (limit - (*c - '0')) / 10)
+            return PAYLOAD_TEXT;
+        value = value * 10 + (*c - '0');
+        if (point)
+            decimals++;
+    }
+
+    int32_t number = negative ? (int32_t)(0 - value) : (int32_t)value;
+    uint8_t type   = PAYLOAD_INT32;
+    *len           = 4;
+    if (point) {
+        type       = PAYLOAD_FIXED;
+        payload[4] = decimals;
+        *len       = 5;
+    } else if (number >= -32768 && number <= 32767) {
+        type = PAYLOAD_INT16;
+        *len = 2;
+    }
+    for (uint8_t i = 0; i < 4; i++, number >>= 8)
+        payload[i] = number & 0xFF;
+    return type;
+}
+
+uint8_t GenericI2C::_crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+/* **********************************************************************************
+    Sends the queued values in their order until the time budget is used up.
+    Values which wait for a retry are skipped until their time has come.
+    With the binary protocol as many frames as fit into the transmit buffer
+    are packed into one transmission, the receiver gets them one after the other.
+    Only values for the same slaves are packed together.
+********************************************************************************** */
 void GenericI2C::update()
 {
-    // Do something which is required regulary
+    uint32_t start = micros();
+    uint8_t  i     = 0;
+
+    while (i < _queueCount && micros() - start < GENERICI2C_UPDATE_BUDGET_US) {
+        if (_queue[i].attempt && (int32_t)(micros() - _queue[i].retryAtUs) < 0) {
+            i++;
+            continue;
+        }
+        uint8_t targets = _queue[i].targets;
+        uint8_t count   = 1;
+        uint8_t failed;
+        if (_protocol == GENERICI2C_PROTOCOL_BINARY) {
+            uint8_t buffer[GENERICI2C_TX_BUFFER];
+            uint8_t used = 0;
+            for (count = 0; i + count < _queueCount; count++) {
+                QueueEntry    *entry = &_queue[i + count];
+                uint8_t        number[5];
+                uint8_t        len;
+                uint8_t        type    = _encode(entry->value, number, &len);
+                const uint8_t *payload = number;
+                if (type == PAYLOAD_TEXT) {
+                    payload = (const uint8_t *)entry->value;
+                    len     = strlen(entry->value);
+                }
+                if (count && (entry->targets != targets || used + len + GENERICI2C_FRAME_OVERHEAD > GENERICI2C_TX_BUFFER ||
+                              (entry->attempt && (int32_t)(micros() - entry->retryAtUs) < 0)))
+                    break;
+                used += _buildFrame(&buffer[used], entry->messageID, type << 5, payload, len);
+            }
+            failed = _transmit(buffer, used, targets);
+        } else {
+            failed = _sendText(_queue[i].messageID, _queue[i].value, targets);
+        }
+        // the sent values are removed, unless they wait for a retry
+        while (count--) {
+            if (failed && _retryLater(i, failed))
+                i++;
+            else
+                _dequeue(i);
+        }
+    }
 }
@@ -2,17 +2,109 @@
 
 #include "Arduino.h"
 
+/* **********************************************************************************
+    Protocols, selected with the first parameter of the config string
+    GENERICI2C_PROTOCOL_TEXT:   messageID followed by the value as string (default)
+    GENERICI2C_PROTOCOL_BINARY: framed and typed values, see README.md
+********************************************************************************** */
+#define GENERICI2C_PROTOCOL_TEXT   0
+#define GENERICI2C_PROTOCOL_BINARY 1
+
+/* **********************************************************************************
+    Optional send queue, enabled with the second parameter of the config string.
+    Only the latest value of each messageID is kept, update() sends them within
+    GENERICI2C_UPDATE_BUDGET_US. Longer values are sent directly.
+    The queue is allocated only if it is enabled or retries wait in it.
+********************************************************************************** */
+#ifndef GENERICI2C_QUEUE_SIZE
+#define GENERICI2C_QUEUE_SIZE 8
+#endif
+#ifndef GENERICI2C_QUEUE_VALUE_LENGTH
+#define GENERICI2C_QUEUE_VALUE_LENGTH 15
+#endif
+#ifndef GENERICI2C_UPDATE_BUDGET_US
+#define GENERICI2C_UPDATE_BUDGET_US 1000
+#endif
+
+// a value on this messageID reports the bus statistics instead of forwarding it
+#define GENERICI2C_MESSAGEID_DIAGNOSTICS 101
+// a stalled bus is released after this time, only if supported by the Wire library
+#define GENERICI2C_WIRE_TIMEOUT_US       25000
+#define GENERICI2C_MAX_RETRIES           5
+// upper limit of the wait time before a retry
+#define GENERICI2C_MAX_BACKOFF_US        100000
+// max. number of slaves which get the same values
+#define GENERICI2C_MAX_ADDRESSES         8
+// the general call address, all slaves which have it enabled receive it
+#define GENERICI2C_BROADCAST_ADDRESS     0
+
 class GenericI2C
 {
 public:
+    enum PayloadTypes : uint8_t {
+        PAYLOAD_TEXT,
+        PAYLOAD_INT16,
+        PAYLOAD_INT32,
+        PAYLOAD_FIXED
+    };
+
     GenericI2C(uint8_t addrI2C);
     void begin();
     void attach();
     void detach();
     void set(int8_t messageID, char *setPoint);
     void update();
+    void setProtocol(uint8_t protocol);
+    void setQueued(bool queued);
+    void setRetries(uint8_t retries, uint16_t backoffUs);
+    void addAddresses(const char *list);
+    void setBroadcast(bool broadcast);
 
 private:
-    bool    _initialised;
-    uint8_t _addrI2C;
-};
\ No newline at end of file
+    struct QueueEntry {
+        int8_t   messageID;
+        uint8_t  attempt;   // 0 = not sent yet, otherwise the number of failed transmissions
+        uint8_t  targets;   // one bit per slave which has to get the value
+        uint32_t retryAtUs; // the entry waits until then if attempt is not 0
+        char     value[GENERICI2C_QUEUE_VALUE_LENGTH + 1];
+    };
+
+    struct Statistics {
+        uint32_t transactions;
+        uint32_t bytes;
+        uint16_t nacks;
+        uint16_t timeouts;
+        uint16_t errors;
+        uint16_t retries;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint32_t totalUs;
+    };
+
+    bool        _initialised;
+    uint8_t     _addrI2C[GENERICI2C_MAX_ADDRESSES];
+    uint8_t     _addrCount = 1;
+    bool        _broadcast = false;
+    uint8_t     _protocol = GENERICI2C_PROTOCOL_TEXT;
+    bool        _queued   = false;
+    QueueEntry *_queue    = nullptr; // allocated by _allocateQueue()
+    uint8_t     _queueCount = 0;
+    uint8_t     _retries    = 0;
+    uint16_t    _backoffUs  = 0;
+    Statistics  _stats      = {0, 0, 0, 0, 0, 0, 0xFFFFFFFF, 0, 0};
+
+    void    _send(int8_t messageID, const char *setPoint);
+    uint8_t _sendText(int8_t messageID, const char *setPoint, uint8_t targets);
+    uint8_t _sendBinary(int8_t messageID, const char *setPoint, uint8_t targets);
+    bool    _allocateQueue();
+    bool    _enqueue(int8_t messageID, const char *setPoint);
+    void    _dequeue(uint8_t index);
+    bool    _retryLater(uint8_t index, uint8_t failed);
+    uint8_t _allTargets();
+    uint8_t _buildFrame(uint8_t *frame, int8_t messageID, uint8_t flags, const uint8_t *payload, uint8_t len);
+    uint8_t _transmit(const uint8_t *data, uint8_t len, uint8_t targets);
+    bool    _transmitTo(uint8_t address, const uint8_t *data, uint8_t len);
+    void    _reportStatistics();
+    uint8_t _encode(const char *setPoint, uint8_t *payload, uint8_t *len);
+    uint8_t _crc8(const uint8_t *data, uint8_t len);
+};
@@ -1,42 +1,15 @@
 #include "MFCustomDevice.h"
 #include "commandmessenger.h"
 #include "allocateMem.h"
-#include "MFEEPROM.h"
-extern MFEEPROM MFeeprom;
+#include "../../_common/CustomDeviceConfig.h"
 
 /* **********************************************************************************
     The custom device pins, type and configuration is stored in the EEPROM
     While loading the config the adresses in the EEPROM are transferred to the constructor
-    Within the constructor you have to copy the EEPROM content to a buffer
-    and evaluate him. The buffer is used for all 3 types (pins, type configuration),
-    so do it step by step.
-    The max size of the buffer is defined here. It must be the size of the
-    expected max length of these strings.
-
-    E.g. 6 pins are required, each pin could have two characters (two digits),
-    each pins are delimited by "|" and the string is NULL terminated.
-    -> (6 * 2) + 5 + 1 = 18 bytes is the maximum.
-    The custom type is "MyCustomClass", which means 14 characters plus NULL = 15
-    The configuration is "myConfig", which means 8 characters plus NULL = 9
-    The maximum characters to be expected is 18, so MEMLEN_STRING_BUFFER has to be at least 18
+    They are read with the helpers in _common/CustomDeviceConfig.h
 ********************************************************************************** */
-#define MEMLEN_STRING_BUFFER 40
 
-// reads a string from EEPROM at given address which is '.' terminated and saves it to the buffer
-bool MFCustomDevice::getStringFromEEPROM(uint16_t addreeprom, char *buffer)
-{
-    char    temp    = 0;
-    uint8_t counter = 0;
-    do {
-        temp              = MFeeprom.read_byte((addreeprom)++); // read the first character
-        buffer[counter++] = temp;                               // save character and locate next buffer position
-        if (counter >= MEMLEN_STRING_BUFFER) {                  // nameBuffer will be exceeded
-            return false;                                       // abort copying to buffer
-        }
-    } while (temp != '.');      // reads until limiter '.' and locates the next free buffer position
-    buffer[counter - 1] = 0x00; // replace '.' by NULL, terminates the string
-    return true;
-}
+static const char GenericI2CName[] PROGMEM = "MOBIFLIGHT_GENERICI2C";
 
 /* **********************************************************************************
     Within the connector pins, a device name and a config string can be defined
@@ -53,17 +26,16 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
         Do something which is required to setup your custom device
     ********************************************************************************** */
 
-    char   *params, *p = NULL;
-    char    parameter[MEMLEN_STRING_BUFFER];
+    char    token[MEMLEN_TOKEN_BUFFER];
+    char    addresses[MEMLEN_TOKEN_BUFFER] = "";
     uint8_t _addrI2C;
 
     /* **********************************************************************************
-        Read the Type from the EEPROM, copy it into a buffer and evaluate it
+        Compare the Type in the EEPROM with the supported type
         The string get's NOT stored as this would need a lot of RAM, instead a variable
         is used to store the type
     ********************************************************************************** */
-    getStringFromEEPROM(adrType, parameter);
-    if (strcmp(parameter, "MOBIFLIGHT_GENERICI2C") == 0)
+    if (CustomDeviceConfig::compareStringFromEEPROM(adrType, GenericI2CName))
         _customType = MOBIFLIGHT_GENERICI2C;
 
     if (_customType == MOBIFLIGHT_GENERICI2C) {
@@ -76,35 +48,35 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
             return;
         }
         /* **********************************************************************************************
-            Read the pins from the EEPROM, copy them into a buffer
-            If you have set '"isI2C": true' in the device.json file, the first value is the I2C address
+            The first pin is the I2C address, decimal or hex with 0x
         ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        /* **********************************************************************************************
-            Split the pins up into single pins. As the number of pins could be different between
-            multiple devices, it is done here.
-        ********************************************************************************************** */
-        params = strtok_r(parameter, "|", &p);
-        _addrI2C  = atoi(params);
+        CustomDeviceConfig::getNumbersFromEEPROM(adrPin, &_addrI2C, 1);
 
         /* **********************************************************************************
-            Read the configuration from the EEPROM, copy it into a buffer.
-        ********************************************************************************** */
-        // getStringFromEEPROM(adrConfig, parameter);
-        /* **********************************************************************************
-            Split the config up into single parameter. As the number of parameters could be
-            different between multiple devices, it is done here.
-            This is just an example how to process the init string. Do NOT use
-            "," or ";" as delimiter for multiple parameters but e.g. "|"
-            For most customer devices it is not required.
-            In this case just delete the following
+            Read the config parameter by parameter from the EEPROM
+            The first parameter selects the protocol, 0 = text (default), 1 = binary
+            The second parameter enables the send queue, 0 = off (default), 1 = on
+            The third and fourth parameter are the number of retries (default 0) and the
+            wait time in us before the first retry
+            The fifth parameter are further I2C addresses, e.g. "0x21+0x22" or "0x21-0x24"
+            The sixth parameter enables broadcast to all slaves, 0 = off (default), 1 = on
         ********************************************************************************** */
-        // uint16_t Parameter1;
-        // char    *Parameter2;
-        // params     = strtok_r(parameter, "|", &p);
-        // Parameter1 = atoi(params);
-        // params     = strtok_r(NULL, "|", &p);
-        // Parameter2 = params;
+        uint8_t  protocol  = GENERICI2C_PROTOCOL_TEXT;
+        bool     queued    = false;
+        uint8_t  retries   = 0;
+        uint16_t backoffUs = 0;
+        bool     broadcast = false;
+        if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+            protocol = atoi(token);
+        if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+            queued = atoi(token) == 1;
+        if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+            retries = atoi(token);
+        if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+            backoffUs = atoi(token);
+        CustomDeviceConfig::getTokenFromEEPROM(adrConfig, addresses, sizeof(addresses));
+        if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+            broadcast = atoi(token) == 1;
 
         /* **********************************************************************************
             Next call the constructor of your custom device
@@ -113,6 +85,11 @@ MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrCo
         // In most cases you need only one of the following functions
         // depending on if the constuctor takes the variables or a separate function is required
         _myGenericI2C = new (allocateMemory(sizeof(GenericI2C))) GenericI2C(_addrI2C);
+        _myGenericI2C->setProtocol(protocol);
+        _myGenericI2C->setQueued(queued);
+        _myGenericI2C->setRetries(retries, backoffUs);
+        _myGenericI2C->addAddresses(addresses);
+        _myGenericI2C->setBroadcast(broadcast);
         // if your custom device does not need a separate begin() function, delete the following
         // or this function could be called from the custom constructor or attach() function
         _myGenericI2C->begin();
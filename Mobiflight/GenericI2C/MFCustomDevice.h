@@ -16,7 +16,6 @@ public:
     void set(int8_t messageID, char *setPoint);
 
 private:
-    bool        getStringFromEEPROM(uint16_t addreeprom, char *buffer);
     bool        _initialized = false;
     GenericI2C *_myGenericI2C;
     uint8_t     _pin1, _pin2, _pin3;
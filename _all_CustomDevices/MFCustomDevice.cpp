@@ -1,47 +1,38 @@
 #include "MFCustomDevice.h"
 #include "commandmessenger.h"
 #include "allocateMem.h"
-#include "MFEEPROM.h"
-extern MFEEPROM MFeeprom;
+#include "../_common/CustomDeviceConfig.h"
 
 /* **********************************************************************************
     The custom device pins, type and configuration is stored in the EEPROM
     While loading the config the adresses in the EEPROM are transferred to the constructor
-    Within the constructor you have to copy the EEPROM content to a buffer
-    and evaluate him. The buffer is used for all 3 types (pins, type configuration),
-    so do it step by step.
-    The max size of the buffer is defined here. It must be the size of the
-    expected max length of these strings.
-    E.g. 6 pins are required, each pin could have two characters (two digits),
-    each pins are delimited by "|" and the string is NULL terminated.
-    -> (6 * 2) + 5 + 1 = 18 bytes is the maximum.
-    The custom type is "MyCustomDevice", which means 14 characters plus NULL = 15
-    The configuration is "myConfig", which means 8 characters plus NULL = 9
-    The maximum characters to be expected is 18, so MEMLEN_STRING_BUFFER has to be at least 18
-
-    For the KAV displays:
-    3 Pins = 9
-    "KAV_EFIS" / "KAV_FCU" = 9
-    no config = 0
+    They are read with the helpers in _common/CustomDeviceConfig.h
+    The type is compared directly against the names in DeviceTypes[].
 ********************************************************************************** */
 
-#define MEMLEN_STRING_BUFFER 20
-
-// reads a string from EEPROM at given address which is '.' terminated and saves it to the buffer
-bool MFCustomDevice::getStringFromEEPROM(uint16_t addreeprom, char *buffer)
-{
-    char    temp    = 0;
-    uint8_t counter = 0;
-    do {
-        temp              = MFeeprom.read_byte((addreeprom)++); // read the first character
-        buffer[counter++] = temp;                               // save character and locate next buffer position
-        if (counter >= MEMLEN_STRING_BUFFER) {                  // nameBuffer will be exceeded
-            return false;                                       // abort copying to buffer
-        }
-    } while (temp != '.');      // reads until limiter '.' and locates the next free buffer position
-    buffer[counter - 1] = 0x00; // replace '.' by NULL, terminates the string
-    return true;
-}
+/* **********************************************************************************
+    Messages which render into the same digits belong to the same group (0 = no group).
+    If the value of one of them changes, the others have to be rendered again even if
+    their value is repeated. E.g. the speed dashes overwrite the speed value.
+********************************************************************************** */
+static const uint8_t FCUMessageGroups[FCU_MESSAGES] PROGMEM = {
+    1, 1, 2, 3, 4, 4, // speed, mach, heading, altitude, vertical, FPA
+    1, 2, 3, 4,       // dashes
+    0, 0, 0, 0,       // dots, Trk/Hdg mode
+    1, 1, 1           // speed label, mach label, speed only
+};
+static const uint8_t EFISMessageGroups[EFIS_MESSAGES] PROGMEM = {
+    1, 1, 1 // QNH, QFE and STD share all digits
+};
+static const uint8_t GlareshieldMessageGroups[GLARESHIELD_MESSAGES] PROGMEM = {
+    1, 1, 2, 3, 4, 4, // FCU like above
+    1, 2, 3, 4,
+    0, 0, 0, 0,
+    1, 1, 1,
+    5, 5, 5, // left EFIS, right EFIS and both EFIS render into the same digits
+    5, 5, 5,
+    5, 5, 5
+};
 
 /* **********************************************************************************
     Within the connector pins, a device name and a config string can be defined
@@ -52,182 +43,269 @@ bool MFCustomDevice::getStringFromEEPROM(uint16_t addreeprom, char *buffer)
     will be called
 ********************************************************************************** */
 
+static const char KAVFCUName[] PROGMEM     = "KAV_FCU";
+static const char KAVEFISName[] PROGMEM    = "KAV_EFIS";
+static const char KAVGlareName[] PROGMEM   = "KAV_GLARESHIELD";
+static const char SegmentName[] PROGMEM    = "HT1621_SEGMENT";
+static const char GNC255Name[] PROGMEM     = "MOBIFLIGHT_GNC255";
+static const char GenericI2CName[] PROGMEM = "MOBIFLIGHT_GENERICI2C";
+
+// the KAV displays are only written from update() if HT1621_ASYNC is defined
+#ifdef HT1621_ASYNC
+#define HT1621_UPDATE(T) updateDevice<T>
+#else
+#define HT1621_UPDATE(T) nullptr
+#endif
+// ms between two updates of the GNC255, each update transfers all changes since the last one
+#ifndef GNC255_UPDATE_INTERVAL
+#define GNC255_UPDATE_INTERVAL 0
+#endif
+
+/* **********************************************************************************
+    To add a new custom device, add its type to the enum in MFCustomDevice.h,
+    write a create function and add an entry here at the same position.
+    The generic I2C device forwards each message, the receiver has to decide about repeats.
+    Instead of the mailbox it has its own send queue with a time budget, so it is updated each loop
+********************************************************************************** */
+const MFCustomDevice::DeviceType MFCustomDevice::DeviceTypes[CUSTOM_DEVICE_TYPES] PROGMEM = {
+    {KAVFCUName, FCUMessageGroups, true, FCU_MESSAGES, 0, createFCU, detachDevice<KAV_A3XX_FCU_LCD>, HT1621_UPDATE(KAV_A3XX_FCU_LCD), setDevice<KAV_A3XX_FCU_LCD>},
+    {KAVEFISName, EFISMessageGroups, true, EFIS_MESSAGES, 0, createEFIS, detachDevice<KAV_A3XX_EFIS_LCD>, HT1621_UPDATE(KAV_A3XX_EFIS_LCD), setDevice<KAV_A3XX_EFIS_LCD>},
+    {KAVGlareName, GlareshieldMessageGroups, true, GLARESHIELD_MESSAGES, 0, createGlareshield, detachDevice<KAV_A3XX_Glareshield>, HT1621_UPDATE(KAV_A3XX_Glareshield), setDevice<KAV_A3XX_Glareshield>},
+    {SegmentName, nullptr, true, GENERIC_SEGMENT_ITEMS, 0, createSegmentLCD, detachDevice<GenericSegmentLCD>, HT1621_UPDATE(GenericSegmentLCD), setDevice<GenericSegmentLCD>},
+    {GNC255Name, nullptr, true, GNC255_MESSAGES, GNC255_UPDATE_INTERVAL, createGNC255, detachDevice<GNC255>, updateDevice<GNC255>, setDevice<GNC255>},
+    {GenericI2CName, nullptr, false, 0, 0, createGenericI2C, detachDevice<GenericI2C>, updateDevice<GenericI2C>, setDevice<GenericI2C>},
+};
+
 MFCustomDevice::MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrConfig)
 {
     /* **********************************************************************************
         Do something which is required to setup your custom device
     ********************************************************************************** */
-    char *params, *p = NULL;
-    char  parameter[MEMLEN_STRING_BUFFER];
-
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    _deviceIndex = _deviceCount++;
+#endif
     /* **********************************************************************************
-        Read the Type from the EEPROM, copy it into a buffer and evaluate it
-        The string get's NOT stored as this would need a lot of RAM, instead a variable
-        is used to store the type
+        Compare the Type in the EEPROM with the supported types
+        The string get's NOT stored as this would need a lot of RAM, instead the index
+        into the device type table is used to store the type
     ********************************************************************************** */
-    getStringFromEEPROM(adrType, parameter);
-    if (strcmp(parameter, "KAV_FCU") == 0)
-        _customType = KAV_LCD_FCU;
-    else if (strcmp(parameter, "KAV_EFIS") == 0)
-        _customType = KAV_LCD_EFIS;
-    else if (strcmp(parameter, "MOBIFLIGHT_GNC255") == 0)
-        _customType = MOBIFLIGHT_GNC255;
-    else if (strcmp(parameter, "MOBIFLIGHT_GENERICI2C") == 0)
-        _customType = MOBIFLIGHT_GENERICI2C;
-
-    if (_customType == KAV_LCD_FCU) {
-        /* **********************************************************************************
-            Check if the device fits into the device buffer
-        ********************************************************************************** */
-        if (!FitInMemory(sizeof(KAV_A3XX_FCU_LCD))) {
-            // Error Message to Connector
-            cmdMessenger.sendCmd(kStatus, F("FCU LCD does not fit in Memory"));
-            return;
-        }
-        /* **********************************************************************************************
-            read the pins from the EEPROM, copy them into a buffer and split them up into single pins
-        ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        /* **********************************************************************************************
-            split the pins up into single pins. As the number of pins could be different between
-            multiple devices, it is done here.
-        ********************************************************************************************** */
-        params        = strtok_r(parameter, "|", &p);
-        uint8_t _pin1 = atoi(params);
-        params        = strtok_r(NULL, "|", &p);
-        uint8_t _pin2 = atoi(params);
-        params        = strtok_r(NULL, "|", &p);
-        uint8_t _pin3 = atoi(params);
-        _FCU_LCD      = new (allocateMemory(sizeof(KAV_A3XX_FCU_LCD))) KAV_A3XX_FCU_LCD(_pin2, _pin3, _pin1);
-        _FCU_LCD->attach(_pin2, _pin3, _pin1);
-
-        _initialized = true;
-    } else if (_customType == KAV_LCD_EFIS) {
-        /* **********************************************************************************
-            Check if the device fits into the device buffer
-        ********************************************************************************** */
-        if (!FitInMemory(sizeof(KAV_A3XX_FCU_LCD))) {
-            // Error Message to Connector
-            cmdMessenger.sendCmd(kStatus, F("EFIS LCD does not fit in Memory"));
-            return;
-        }
-        /* **********************************************************************************************
-            read the pins from the EEPROM, copy them into a buffer and split them up into single pins
-        ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        /* **********************************************************************************************
-            split the pins up into single pins. As the number of pins could be different between
-            multiple devices, it is done here.
-        ********************************************************************************************** */
-        params        = strtok_r(parameter, "|", &p);
-        uint8_t _pin1 = atoi(params);
-        params        = strtok_r(NULL, "|", &p);
-        uint8_t _pin2 = atoi(params);
-        params        = strtok_r(NULL, "|", &p);
-        uint8_t _pin3 = atoi(params);
-        _EFIS_LCD     = new (allocateMemory(sizeof(KAV_A3XX_EFIS_LCD))) KAV_A3XX_EFIS_LCD(_pin2, _pin3, _pin1);
-        _EFIS_LCD->attach(_pin2, _pin3, _pin1);
-
-        _initialized = true;
-    } else if (_customType == MOBIFLIGHT_GNC255) {
-        /* **********************************************************************************
-            Check if the device fits into the device buffer
-        ********************************************************************************** */
-        if (!FitInMemory(sizeof(GNC255))) {
-            // Error Message to Connector
-            cmdMessenger.sendCmd(kStatus, F("Custom Device does not fit in Memory"));
-            return;
-        }
-        /* **********************************************************************************************
-            read the pins from the EEPROM, copy them into a buffer and split them up die single pins
-            As the number of pins could be different between multiple devices, it is done here.
-        ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        params         = strtok_r(parameter, "|", &p);
-        uint8_t _clk   = atoi(params);
-        params         = strtok_r(NULL, "|", &p);
-        uint8_t _data  = atoi(params);
-        params         = strtok_r(NULL, "|", &p);
-        uint8_t _cs    = atoi(params);
-        params         = strtok_r(NULL, "|", &p);
-        uint8_t _dc    = atoi(params);
-        params         = strtok_r(NULL, "|", &p);
-        uint8_t _reset = atoi(params);
-        /* **********************************************************************************
-            Next call the constructor of your custom device
-            adapt it to the needs of your constructor
-        ********************************************************************************** */
-        _GNC255_OLED = new (allocateMemory(sizeof(GNC255))) GNC255(_clk, _data, _cs, _dc, _reset);
-        _GNC255_OLED->attach();
-
-        _initialized = true;
-    } else if (_customType == MOBIFLIGHT_GENERICI2C) {
-        /* **********************************************************************************
-            Check if the device fits into the device buffer
-        ********************************************************************************** */
-        if (!FitInMemory(sizeof(GenericI2C))) {
-            // Error Message to Connector
-            cmdMessenger.sendCmd(kStatus, F("Custom Device does not fit in Memory"));
-            return;
-        }
-        /* **********************************************************************************************
-            Read the pins from the EEPROM, copy them into a buffer
-            If you have set '"isI2C": true' in the device.json file, the first value is the I2C address
-        ********************************************************************************************** */
-        getStringFromEEPROM(adrPin, parameter);
-        /* **********************************************************************************************
-            Split the pins up into single pins. As the number of pins could be different between
-            multiple devices, it is done here.
-        ********************************************************************************************** */
-        params           = strtok_r(parameter, "|", &p);
-        uint8_t _addrI2C = atoi(params);
-
-        /* **********************************************************************************
-            Read the configuration from the EEPROM, copy it into a buffer.
-        ********************************************************************************** */
-        // getStringFromEEPROM(adrConfig, parameter);
-        /* **********************************************************************************
-            Split the config up into single parameter. As the number of parameters could be
-            different between multiple devices, it is done here.
-            This is just an example how to process the init string. Do NOT use
-            "," or ";" as delimiter for multiple parameters but e.g. "|"
-            For most customer devices it is not required.
-            In this case just delete the following
-        ********************************************************************************** */
-        // uint16_t Parameter1;
-        // char    *Parameter2;
-        // params     = strtok_r(parameter, "|", &p);
-        // Parameter1 = atoi(params);
-        // params     = strtok_r(NULL, "|", &p);
-        // Parameter2 = params;
-
-        /* **********************************************************************************
-            Next call the constructor of your custom device
-            adapt it to the needs of your constructor
-        ********************************************************************************** */
-        // In most cases you need only one of the following functions
-        // depending on if the constuctor takes the variables or a separate function is required
-        _myGenericI2C = new (allocateMemory(sizeof(GenericI2C))) GenericI2C(_addrI2C);
-        // if your custom device does not need a separate begin() function, delete the following
-        // or this function could be called from the custom constructor or attach() function
-        _myGenericI2C->begin();
-        _initialized = true;
-    } else {
+    for (_customType = 0; _customType < CUSTOM_DEVICE_TYPES; _customType++) {
+        if (CustomDeviceConfig::compareStringFromEEPROM(adrType, (const char *)pgm_read_ptr(&DeviceTypes[_customType].name)))
+            break;
+    }
+    if (_customType == CUSTOM_DEVICE_TYPES) {
         cmdMessenger.sendCmd(kStatus, F("Custom Device is not supported by this firmware version"));
+        return;
+    }
+
+    typedef void *(*CreateFunction)(uint16_t, uint16_t);
+    _device = ((CreateFunction)pgm_read_ptr(&DeviceTypes[_customType].create))(adrPin, adrConfig);
+    if (_device == nullptr)
+        return;
+    _messageGroups = (const uint8_t *)pgm_read_ptr(&DeviceTypes[_customType].messageGroups);
+    allocateCache(pgm_read_byte(&DeviceTypes[_customType].cachedMessages));
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    allocateProfile(max(pgm_read_byte(&DeviceTypes[_customType].cachedMessages), (uint8_t)PROFILE_MESSAGES));
+#endif
+    _initialized = true;
+}
+
+void *MFCustomDevice::createFCU(uint16_t adrPin, uint16_t adrConfig)
+{
+    uint8_t pins[3];
+
+    /* **********************************************************************************
+        Check if the device fits into the device buffer
+    ********************************************************************************** */
+    if (!FitInMemory(sizeof(KAV_A3XX_FCU_LCD))) {
+        // Error Message to Connector
+        cmdMessenger.sendCmd(kStatus, F("FCU LCD does not fit in Memory"));
+        return nullptr;
+    }
+    /* **********************************************************************************************
+        read the pins from the EEPROM and split them up into single pins
+    ********************************************************************************************** */
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 3);
+    KAV_A3XX_FCU_LCD *_FCU_LCD = new (allocateMemory(sizeof(KAV_A3XX_FCU_LCD))) KAV_A3XX_FCU_LCD(pins[1], pins[2], pins[0]);
+    _FCU_LCD->attach(pins[1], pins[2], pins[0]);
+    return _FCU_LCD;
+}
+
+void *MFCustomDevice::createEFIS(uint16_t adrPin, uint16_t adrConfig)
+{
+    uint8_t pins[3];
+
+    /* **********************************************************************************
+        Check if the device fits into the device buffer
+    ********************************************************************************** */
+    if (!FitInMemory(sizeof(KAV_A3XX_EFIS_LCD))) {
+        // Error Message to Connector
+        cmdMessenger.sendCmd(kStatus, F("EFIS LCD does not fit in Memory"));
+        return nullptr;
+    }
+    /* **********************************************************************************************
+        read the pins from the EEPROM and split them up into single pins
+    ********************************************************************************************** */
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 3);
+    KAV_A3XX_EFIS_LCD *_EFIS_LCD = new (allocateMemory(sizeof(KAV_A3XX_EFIS_LCD))) KAV_A3XX_EFIS_LCD(pins[1], pins[2], pins[0]);
+    _EFIS_LCD->attach(pins[1], pins[2], pins[0]);
+    return _EFIS_LCD;
+}
+
+void *MFCustomDevice::createGlareshield(uint16_t adrPin, uint16_t adrConfig)
+{
+    uint8_t pins[7];
+
+    /* **********************************************************************************
+        Check if the device fits into the device buffer
+    ********************************************************************************** */
+    if (!FitInMemory(sizeof(KAV_A3XX_Glareshield))) {
+        // Error Message to Connector
+        cmdMessenger.sendCmd(kStatus, F("Glareshield LCDs do not fit in Memory"));
+        return nullptr;
+    }
+    /* **********************************************************************************************
+        read the pins from the EEPROM and split them up into single pins
+        Data FCU|Data left EFIS|Data right EFIS|CS FCU|CS left EFIS|CS right EFIS|CLK
+    ********************************************************************************************** */
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 7);
+    KAV_A3XX_Glareshield *_Glareshield = new (allocateMemory(sizeof(KAV_A3XX_Glareshield))) KAV_A3XX_Glareshield(&pins[3], pins[6], &pins[0]);
+    _Glareshield->attach();
+    return _Glareshield;
+}
+
+void *MFCustomDevice::createSegmentLCD(uint16_t adrPin, uint16_t adrConfig)
+{
+    uint8_t pins[3];
+    char    token[MEMLEN_TOKEN_BUFFER];
+
+    /* **********************************************************************************
+        Check if the device fits into the device buffer
+    ********************************************************************************** */
+    if (!FitInMemory(sizeof(GenericSegmentLCD))) {
+        // Error Message to Connector
+        cmdMessenger.sendCmd(kStatus, F("Segment LCD does not fit in Memory"));
+        return nullptr;
+    }
+    /* **********************************************************************************************
+        read the pins from the EEPROM and split them up into single pins
+    ********************************************************************************************** */
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 3);
+    GenericSegmentLCD *_SegmentLCD = new (allocateMemory(sizeof(GenericSegmentLCD))) GenericSegmentLCD(pins[1], pins[2], pins[0]);
+    /* **********************************************************************************************
+        each token of the config defines the wiring, a field or an annunciator
+        see GenericSegmentLCD.h for the format
+    ********************************************************************************************** */
+    while (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token))) {
+        if (!_SegmentLCD->addConfig(token))
+            cmdMessenger.sendCmd(kStatus, F("Segment LCD config is not valid"));
+    }
+    _SegmentLCD->attach(pins[1], pins[2], pins[0]);
+    return _SegmentLCD;
+}
+
+void *MFCustomDevice::createGNC255(uint16_t adrPin, uint16_t adrConfig)
+{
+    uint8_t pins[5];
+
+    /* **********************************************************************************
+        Check if the device fits into the device buffer
+    ********************************************************************************** */
+    if (!FitInMemory(sizeof(GNC255))) {
+        // Error Message to Connector
+        cmdMessenger.sendCmd(kStatus, F("Custom Device does not fit in Memory"));
+        return nullptr;
     }
+    /* **********************************************************************************************
+        read the pins from the EEPROM and split them up into single pins: clk, data, cs, dc, reset
+    ********************************************************************************************** */
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, pins, 5);
+    /* **********************************************************************************
+        Next call the constructor of your custom device
+        adapt it to the needs of your constructor
+    ********************************************************************************** */
+    GNC255 *_GNC255_OLED = new (allocateMemory(sizeof(GNC255))) GNC255(pins[0], pins[1], pins[2], pins[3], pins[4]);
+    _GNC255_OLED->attach();
+    return _GNC255_OLED;
+}
+
+void *MFCustomDevice::createGenericI2C(uint16_t adrPin, uint16_t adrConfig)
+{
+    char    token[MEMLEN_TOKEN_BUFFER];
+    char    addresses[MEMLEN_TOKEN_BUFFER] = "";
+    uint8_t _addrI2C;
+
+    /* **********************************************************************************
+        Check if the device fits into the device buffer
+    ********************************************************************************** */
+    if (!FitInMemory(sizeof(GenericI2C))) {
+        // Error Message to Connector
+        cmdMessenger.sendCmd(kStatus, F("Custom Device does not fit in Memory"));
+        return nullptr;
+    }
+    /* **********************************************************************************************
+        Read the pins from the EEPROM
+        If you have set '"isI2C": true' in the device.json file, the first value is the I2C address
+    ********************************************************************************************** */
+    CustomDeviceConfig::getNumbersFromEEPROM(adrPin, &_addrI2C, 1);
+
+    /* **********************************************************************************
+        Read the config from the EEPROM parameter by parameter, missing ones keep their default
+        The first parameter selects the protocol, 0 = text (default), 1 = binary
+        The second parameter enables the send queue, 0 = off (default), 1 = on
+        The third and fourth parameter are the number of retries (default 0) and the
+        wait time in us before the first retry
+        The fifth parameter are further I2C addresses, e.g. "0x21+0x22" or "0x21-0x24"
+        The sixth parameter enables broadcast to all slaves, 0 = off (default), 1 = on
+    ********************************************************************************** */
+    uint8_t  protocol  = GENERICI2C_PROTOCOL_TEXT;
+    bool     queued    = false;
+    uint8_t  retries   = 0;
+    uint16_t backoffUs = 0;
+    bool     broadcast = false;
+    if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+        protocol = atoi(token);
+    if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+        queued = atoi(token) == 1;
+    if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+        retries = atoi(token);
+    if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+        backoffUs = atoi(token);
+    CustomDeviceConfig::getTokenFromEEPROM(adrConfig, addresses, sizeof(addresses));
+    if (CustomDeviceConfig::getTokenFromEEPROM(adrConfig, token, sizeof(token)))
+        broadcast = atoi(token) == 1;
+
+    /* **********************************************************************************
+        Next call the constructor of your custom device
+        adapt it to the needs of your constructor
+    ********************************************************************************** */
+    // In most cases you need only one of the following functions
+    // depending on if the constuctor takes the variables or a separate function is required
+    GenericI2C *_myGenericI2C = new (allocateMemory(sizeof(GenericI2C))) GenericI2C(_addrI2C);
+    _myGenericI2C->setProtocol(protocol);
+    _myGenericI2C->setQueued(queued);
+    _myGenericI2C->setRetries(retries, backoffUs);
+    _myGenericI2C->addAddresses(addresses);
+    _myGenericI2C->setBroadcast(broadcast);
+    // if your custom device does not need a separate begin() function, delete the following
+    // or this function could be called from the custom constructor or attach() function
+    _myGenericI2C->begin();
+    return _myGenericI2C;
 }
 
 void MFCustomDevice::detach()
 {
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    // all devices are detached before a new config is loaded, the next one gets index 0 again
+    _deviceCount = 0;
+#endif
+    if (!_initialized) return;
     _initialized = false;
-    if (_customType == KAV_LCD_FCU)
-        _FCU_LCD->detach();
-    else if (_customType == KAV_LCD_EFIS)
-        _EFIS_LCD->detach();
-    else if (_customType == MOBIFLIGHT_GNC255)
-        _GNC255_OLED->detach();
-    else if (_customType == MOBIFLIGHT_GENERICI2C)
-        _myGenericI2C->detach();
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+    _mailCount = 0;
+#endif
+    typedef void (*DetachFunction)(void *);
+    ((DetachFunction)pgm_read_ptr(&DeviceTypes[_customType].detach))(_device);
 }
 
 /* **********************************************************************************
@@ -242,19 +320,31 @@ void MFCustomDevice::detach()
 void MFCustomDevice::update()
 {
     if (!_initialized) return;
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+    drainMailbox(MAILBOX_BUDGET_US);
+#endif
     /* **********************************************************************************
-        Do something if required
-        -> Nothing todo for this device
+        Each device type defines if and how often it needs to be updated, see DeviceTypes[]
+        Devices which do not need it return here without any further work
     ********************************************************************************** */
-    if (_customType == KAV_LCD_FCU) {
-        // no update() function for this device
-    } else if (_customType == KAV_LCD_EFIS) {
-        // no update() function for this device
-    } else if (_customType == MOBIFLIGHT_GNC255) {
-        // no update() function for this device
-    } else if (_customType == MOBIFLIGHT_GENERICI2C) {
-        // no update() function for this device
+    typedef void (*UpdateFunction)(void *);
+    UpdateFunction updateFunction = (UpdateFunction)pgm_read_ptr(&DeviceTypes[_customType].update);
+    if (updateFunction == nullptr)
+        return;
+    uint16_t interval = pgm_read_word(&DeviceTypes[_customType].updateInterval);
+    if (interval) {
+        uint32_t now = millis();
+        if (now - _lastUpdate < interval)
+            return;
+        _lastUpdate = now;
     }
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    uint32_t start = micros();
+#endif
+    updateFunction(_device);
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    profile(_profileMessages + 1, micros() - start);
+#endif
 }
 
 /* **********************************************************************************
@@ -266,12 +356,251 @@ void MFCustomDevice::set(int8_t messageID, char *setPoint)
 {
     if (!_initialized) return;
 
-    if (_customType == KAV_LCD_FCU)
-        _FCU_LCD->set(messageID, setPoint);
-    else if (_customType == KAV_LCD_EFIS)
-        _EFIS_LCD->set(messageID, setPoint);
-    else if (_customType == MOBIFLIGHT_GNC255)
-        _GNC255_OLED->set(messageID, setPoint);
-    else if (_customType == MOBIFLIGHT_GENERICI2C)
-        _myGenericI2C->set(messageID, setPoint);
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    if (messageID == MESSAGEID_DIAGNOSTICS) {
+        reportProfile();
+        // the generic I2C device reports its bus statistics on the same messageID
+        if (pgm_read_byte(&DeviceTypes[_customType].coalesceMessages))
+            return;
+    }
+#endif
+
+    if (pgm_read_byte(&DeviceTypes[_customType].coalesceMessages)) {
+        if (messageID == MESSAGEID_FORCE_REFRESH) {
+            _lastValueValid = 0;
+            cmdMessenger.sendCmdStart(kStatus);
+            cmdMessenger.sendCmdArg(F("Repeated messages dropped"));
+            cmdMessenger.sendCmdArg(_droppedMessages);
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+            cmdMessenger.sendCmdArg(F("Mailbox depth"));
+            cmdMessenger.sendCmdArg(_mailCount);
+            cmdMessenger.sendCmdArg(F("Mailbox overwritten"));
+            cmdMessenger.sendCmdArg(_mailOverwritten);
+#endif
+            cmdMessenger.sendCmdEnd();
+            return;
+        }
+        if (isRepeatedMessage(messageID, setPoint)) return;
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+        // special messageIDs (e.g. -1, -2) must not overtake the values before
+        if (messageID < 0)
+            drainMailbox(0xFFFFFFFF);
+        else if (postMail(messageID, setPoint))
+            return;
+#endif
+    }
+    forward(messageID, setPoint);
+}
+
+void MFCustomDevice::forward(int8_t messageID, char *setPoint)
+{
+    typedef void (*SetFunction)(void *, int8_t, char *);
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    uint32_t start = micros();
+#endif
+    ((SetFunction)pgm_read_ptr(&DeviceTypes[_customType].set))(_device, messageID, setPoint);
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    profile(messageID >= 0 && messageID < _profileMessages ? messageID : _profileMessages, micros() - start);
+#endif
+}
+
+#ifdef MF_CUSTOMDEVICE_PROFILING
+uint8_t MFCustomDevice::_deviceCount = 0;
+
+// one slot per messageID, one for all other messageIDs and one for update()
+void MFCustomDevice::allocateProfile(uint8_t messages)
+{
+    uint16_t size = (messages + 2) * sizeof(Profile);
+
+    if (!FitInMemory(size)) {
+        cmdMessenger.sendCmd(kStatus, F("Profile does not fit in Memory"));
+        return;
+    }
+    _profile = (Profile *)allocateMemory(size);
+    memset(_profile, 0, size);
+    _profileMessages = messages;
+}
+
+void MFCustomDevice::profile(uint8_t slot, uint32_t durationUs)
+{
+    uint8_t bucket = 0;
+
+    if (_profile == nullptr)
+        return;
+    for (uint32_t limit = 4; durationUs >= limit && bucket < PROFILE_BUCKETS - 1; limit <<= 2)
+        bucket++;
+    if (_profile[slot].buckets[bucket] < 0xFFFF)
+        _profile[slot].buckets[bucket]++;
+    if (durationUs > _profile[slot].maxUs)
+        _profile[slot].maxUs = durationUs;
+}
+
+// one status message for each messageID of this device which was forwarded and for update()
+void MFCustomDevice::reportProfile()
+{
+    for (uint8_t slot = 0; _profile && slot < _profileMessages + 2; slot++) {
+        if (_profile[slot].maxUs == 0 && _profile[slot].buckets[0] == 0)
+            continue;
+        cmdMessenger.sendCmdStart(kStatus);
+        cmdMessenger.sendCmdArg(F("Profile"));
+        cmdMessenger.sendCmdArg((const __FlashStringHelper *)pgm_read_ptr(&DeviceTypes[_customType].name));
+        cmdMessenger.sendCmdArg(_deviceIndex);
+        if (slot < _profileMessages) {
+            cmdMessenger.sendCmdArg(F("messageID"));
+            cmdMessenger.sendCmdArg(slot);
+        } else if (slot == _profileMessages) {
+            cmdMessenger.sendCmdArg(F("other messageIDs"));
+        } else {
+            cmdMessenger.sendCmdArg(F("update()"));
+        }
+        cmdMessenger.sendCmdArg(F("Calls per bucket"));
+        for (uint8_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++)
+            cmdMessenger.sendCmdArg(_profile[slot].buckets[bucket]);
+        cmdMessenger.sendCmdArg(F("Max us"));
+        cmdMessenger.sendCmdArg(_profile[slot].maxUs);
+        cmdMessenger.sendCmdEnd();
+    }
+}
+#endif
+
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+/* **********************************************************************************
+    The mailbox keeps the order in which the messageIDs were received last. A new value
+    of a messageID which is already in the mailbox replaces the old one and moves it to
+    the end, together with all other values of its message group. So a group is
+    forwarded in one piece and in the order of the last changes, e.g. speed, mach,
+    speed ends in speed mode.
+    Returns false if the value has to be forwarded directly, all values in the mailbox
+    are forwarded before, so it does not overtake them.
+********************************************************************************** */
+bool MFCustomDevice::postMail(int8_t messageID, const char *setPoint)
+{
+    uint8_t group = messageGroup(messageID);
+    uint8_t moved = 0;
+    uint8_t i     = 0;
+
+    if (strlen(setPoint) > MAILBOX_VALUE_LENGTH) {
+        drainMailbox(0xFFFFFFFF);
+        return false;
+    }
+    // remove an older value of this messageID
+    while (i < _mailCount && _mailbox[i].messageID != messageID)
+        i++;
+    if (i < _mailCount) {
+        memmove(&_mailbox[i], &_mailbox[i + 1], (_mailCount - i - 1) * sizeof(Mail));
+        _mailCount--;
+        _mailOverwritten++;
+    }
+    if (_mailCount == MAILBOX_SIZE) {
+        drainMailbox(0xFFFFFFFF);
+        return false;
+    }
+    // move the values of the same group to the end, their order is kept
+    for (i = 0; group && i < _mailCount - moved;) {
+        if (messageGroup(_mailbox[i].messageID) == group) {
+            Mail mail = _mailbox[i];
+            memmove(&_mailbox[i], &_mailbox[i + 1], (_mailCount - i - 1) * sizeof(Mail));
+            _mailbox[_mailCount - 1] = mail;
+            moved++;
+        } else {
+            i++;
+        }
+    }
+    _mailbox[_mailCount].messageID = messageID;
+    strcpy(_mailbox[_mailCount].value, setPoint);
+    _mailCount++;
+    return true;
+}
+
+// forwards the values in the mailbox in their order until the time budget is used up, a group is never split up
+void MFCustomDevice::drainMailbox(uint32_t budgetUs)
+{
+    uint32_t start = micros();
+
+    while (_mailCount && micros() - start < budgetUs) {
+        uint8_t group = messageGroup(_mailbox[0].messageID);
+        do {
+            forward(_mailbox[0].messageID, _mailbox[0].value);
+            memmove(&_mailbox[0], &_mailbox[1], (_mailCount - 1) * sizeof(Mail));
+            _mailCount--;
+        } while (_mailCount && group && messageGroup(_mailbox[0].messageID) == group);
+    }
+}
+
+uint8_t MFCustomDevice::getMailboxDepth()
+{
+    return _mailCount;
+}
+
+uint16_t MFCustomDevice::getMailboxOverwritten()
+{
+    return _mailOverwritten;
+}
+#endif
+
+/* **********************************************************************************
+    MobiFlight sends unchanged values quite often, e.g. after a config reload or if
+    a sim variable jitters around the same rounded value. A hash of the last value
+    of each messageID is stored, exact repeats are not forwarded to the device.
+    Special messageIDs (e.g. -1, -2) clear the cache as they change the display,
+    messageIDs beyond the cache are forwarded without changing it.
+    The cache is allocated from the device buffer with 4 bytes per messageID of the
+    device type, devices without cache need no memory for it. If it does not fit,
+    all values are forwarded.
+    If a new value has the same hash as the last one, it is dropped as a repeat.
+    This is unlikely for the short values, but would keep the display unchanged
+    until the next change of this messageID or a Force Refresh.
+********************************************************************************** */
+void MFCustomDevice::allocateCache(uint8_t messages)
+{
+    if (messages == 0)
+        return;
+    if (!FitInMemory(messages * sizeof(uint32_t))) {
+        cmdMessenger.sendCmd(kStatus, F("Message cache does not fit in Memory"));
+        return;
+    }
+    _lastValueHash = (uint32_t *)allocateMemory(messages * sizeof(uint32_t));
+    _cacheSize     = messages;
+}
+
+bool MFCustomDevice::isRepeatedMessage(int8_t messageID, const char *setPoint)
+{
+    if (messageID < 0) {
+        _lastValueValid = 0;
+        return false;
+    }
+    if (messageID >= _cacheSize)
+        return false;
+    // FNV-1a, a changed value with the same hash as the last one (about 1 in 2^32) is dropped as well,
+    // the next change or the messageID which clears the cache renders it again
+    uint32_t hash = 2166136261ul;
+    while (*setPoint)
+        hash = (hash ^ (uint8_t)*setPoint++) * 16777619ul;
+
+    if ((_lastValueValid & (1ul << messageID)) && _lastValueHash[messageID] == hash) {
+        _droppedMessages++;
+        return true;
+    }
+    _lastValueHash[messageID] = hash;
+    // messages of the same group render into the same digits, their cached values are not valid anymore
+    uint8_t group = messageGroup(messageID);
+    for (uint8_t i = 0; group && i < _cacheSize; i++) {
+        if (messageGroup(i) == group)
+            _lastValueValid &= ~(1ul << i);
+    }
+    _lastValueValid |= 1ul << messageID;
+    return false;
+}
+
+// group of the messageID, 0 if the messages of the device are not grouped
+uint8_t MFCustomDevice::messageGroup(int8_t messageID)
+{
+    if (_messageGroups == nullptr || messageID < 0 || messageID >= pgm_read_byte(&DeviceTypes[_customType].cachedMessages))
+        return 0;
+    return pgm_read_byte(&_messageGroups[messageID]);
+}
+
+uint16_t MFCustomDevice::getDroppedMessages()
+{
+    return _droppedMessages;
 }
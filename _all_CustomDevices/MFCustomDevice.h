@@ -3,30 +3,146 @@
 #include <Arduino.h>
 #include "../KAV_Simulation/EFIS_FCU/KAV_A3XX_FCU_LCD.h"
 #include "../KAV_Simulation/EFIS_FCU/KAV_A3XX_EFIS_LCD.h"
+#include "../KAV_Simulation/EFIS_FCU/KAV_A3XX_Glareshield.h"
+#include "../KAV_Simulation/EFIS_FCU/GenericSegmentLCD.h"
 #include "../Mobiflight/GNC255/GNC255.h"
 #include "../Mobiflight/GenericI2C/GenericI2C.h"
 
+// messageID to clear the same-value cache, afterwards the next value of each messageID is rendered again
+#define MESSAGEID_FORCE_REFRESH 100
+
+/* **********************************************************************************
+    Define MF_CUSTOMDEVICE_MAILBOX to forward the messages from update() instead of set().
+    Only the latest value of each messageID is kept and forwarded within
+    MAILBOX_BUDGET_US per update(), so a burst of messages does not render stale values.
+    The values are forwarded in the order of their last change, the messages of a
+    message group are forwarded together.
+********************************************************************************** */
+/* **********************************************************************************
+    Define MF_CUSTOMDEVICE_PROFILING to measure the time of each call into the driver.
+    Per messageID the calls are counted in buckets of 0-3us, 4-15us, 16-63us, ...
+    (factor 4, the last one >= 16384us) and the max. time is kept. Each custom device
+    has its own table with one slot per cached messageID (PROFILE_MESSAGES for devices
+    without cache), one slot for all other messageIDs and one for update().
+    The table is allocated from the device buffer, 20 bytes per slot.
+    A value on MESSAGEID_DIAGNOSTICS sends the table of this device to the connector,
+    each line is tagged with the device type and the index of the device in the config.
+********************************************************************************** */
+#define MESSAGEID_DIAGNOSTICS 101
+#ifdef MF_CUSTOMDEVICE_PROFILING
+#define PROFILE_BUCKETS  8
+#define PROFILE_MESSAGES 8
+#endif
+
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+#ifndef MF_CUSTOMDEVICE_HAS_UPDATE
+#error "MF_CUSTOMDEVICE_MAILBOX requires MF_CUSTOMDEVICE_HAS_UPDATE"
+#endif
+#ifndef MAILBOX_SIZE
+#define MAILBOX_SIZE 8
+#endif
+#ifndef MAILBOX_VALUE_LENGTH
+#define MAILBOX_VALUE_LENGTH 15
+#endif
+#ifndef MAILBOX_BUDGET_US
+#define MAILBOX_BUDGET_US 2000
+#endif
+#endif
+
+// index into the device type table, the order must match DeviceTypes[] in MFCustomDevice.cpp
 enum {
     KAV_LCD_FCU,
     KAV_LCD_EFIS,
+    KAV_LCD_GLARESHIELD,
+    HT1621_SEGMENT_LCD,
     MOBIFLIGHT_GNC255,
-    MOBIFLIGHT_GENERICI2C
+    MOBIFLIGHT_GENERICI2C,
+    CUSTOM_DEVICE_TYPES
 };
 
 class MFCustomDevice
 {
 public:
     MFCustomDevice(uint16_t adrPin, uint16_t adrType, uint16_t adrConfig);
-    void detach();
-    void update();
-    void set(int8_t messageID, char *setPoint);
+    void     detach();
+    void     update();
+    void     set(int8_t messageID, char *setPoint);
+    uint16_t getDroppedMessages();
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+    uint8_t  getMailboxDepth();
+    uint16_t getMailboxOverwritten();
+#endif
 
 private:
-    bool               getStringFromEEPROM(uint16_t addreeprom, char *buffer);
-    bool               _initialized = false;
-    KAV_A3XX_FCU_LCD  *_FCU_LCD;
-    KAV_A3XX_EFIS_LCD *_EFIS_LCD;
-    GNC255            *_GNC255_OLED;
-    GenericI2C        *_myGenericI2C;
-    uint8_t            _customType;
+    /* **********************************************************************************
+        One entry per supported custom device, stored in PROGMEM.
+        create() reads the pins and config from the EEPROM and constructs the device,
+        it returns nullptr if the device does not fit in memory.
+        The other functions forward to the device which is stored as void pointer.
+        update is nullptr if the device does not need it, otherwise it is called
+        every updateInterval ms (0 = each time MFCustomDevice::update() is called).
+    ********************************************************************************** */
+    struct DeviceType {
+        const char    *name;
+        const uint8_t *messageGroups;    // nullptr if the messages are not grouped
+        bool           coalesceMessages; // false if each message must be forwarded (no cache, no mailbox)
+        uint8_t        cachedMessages;   // messageIDs 0 to cachedMessages - 1 are cached (max. 32)
+        uint16_t       updateInterval;
+        void *(*create)(uint16_t adrPin, uint16_t adrConfig);
+        void (*detach)(void *device);
+        void (*update)(void *device);
+        void (*set)(void *device, int8_t messageID, char *setPoint);
+    };
+    static const DeviceType DeviceTypes[CUSTOM_DEVICE_TYPES];
+
+    static void   *createFCU(uint16_t adrPin, uint16_t adrConfig);
+    static void   *createEFIS(uint16_t adrPin, uint16_t adrConfig);
+    static void   *createGlareshield(uint16_t adrPin, uint16_t adrConfig);
+    static void   *createSegmentLCD(uint16_t adrPin, uint16_t adrConfig);
+    static void   *createGNC255(uint16_t adrPin, uint16_t adrConfig);
+    static void   *createGenericI2C(uint16_t adrPin, uint16_t adrConfig);
+    template <class T>
+    static void detachDevice(void *device) { static_cast<T *>(device)->detach(); }
+    template <class T>
+    static void updateDevice(void *device) { static_cast<T *>(device)->update(); }
+    template <class T>
+    static void setDevice(void *device, int8_t messageID, char *setPoint) { static_cast<T *>(device)->set(messageID, setPoint); }
+
+    bool           _initialized = false;
+    void          *_device      = nullptr;
+    uint8_t        _customType  = CUSTOM_DEVICE_TYPES;
+    uint32_t       _lastUpdate  = 0;
+    void           allocateCache(uint8_t messages);
+    bool           isRepeatedMessage(int8_t messageID, const char *setPoint);
+    uint32_t      *_lastValueHash   = nullptr;
+    uint8_t        _cacheSize       = 0;
+    uint32_t       _lastValueValid  = 0;
+    uint16_t       _droppedMessages = 0;
+    const uint8_t *_messageGroups   = nullptr;
+    uint8_t        messageGroup(int8_t messageID);
+    void           forward(int8_t messageID, char *setPoint);
+#ifdef MF_CUSTOMDEVICE_PROFILING
+    struct Profile {
+        uint16_t buckets[PROFILE_BUCKETS];
+        uint32_t maxUs;
+    };
+    void           allocateProfile(uint8_t messages);
+    void           profile(uint8_t slot, uint32_t durationUs);
+    void           reportProfile();
+    Profile       *_profile         = nullptr;
+    uint8_t        _profileMessages = 0; // slot _profileMessages for other messageIDs, the next one for update()
+    uint8_t        _deviceIndex;
+    static uint8_t _deviceCount;
+#endif
+#ifdef MF_CUSTOMDEVICE_MAILBOX
+    struct Mail {
+        int8_t messageID;
+        char   value[MAILBOX_VALUE_LENGTH + 1];
+    };
+    bool     postMail(int8_t messageID, const char *setPoint);
+    void     drainMailbox(uint32_t budgetUs);
+    Mail     _mailbox[MAILBOX_SIZE];
+    uint8_t  _mailCount       = 0;
+    uint16_t _mailOverwritten = 0;
+#endif
 };
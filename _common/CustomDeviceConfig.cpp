@@ -0,0 +1,69 @@
+#include "CustomDeviceConfig.h"
+#include "MFEEPROM.h"
+extern MFEEPROM MFeeprom;
+
+// the end of a string, also for an erased or not written EEPROM
+static bool isEndOfString(char c)
+{
+    return c == '.' || c == 0x00 || c == (char)0xFF;
+}
+
+bool CustomDeviceConfig::compareStringFromEEPROM(uint16_t addreeprom, const char *text)
+{
+    char temp, expected;
+    do {
+        temp     = MFeeprom.read_byte(addreeprom++);
+        expected = pgm_read_byte(text++);
+        if (isEndOfString(temp))
+            return expected == 0x00;
+    } while (temp == expected);
+    return false;
+}
+
+bool CustomDeviceConfig::getTokenFromEEPROM(uint16_t &addreeprom, char *token, uint8_t size)
+{
+    uint8_t counter = 0;
+    char    temp    = MFeeprom.read_byte(addreeprom);
+
+    if (isEndOfString(temp))
+        return false;
+    while (!isEndOfString(temp)) {
+        addreeprom++;
+        if (temp == '|')
+            break;
+        if (counter < size - 1)
+            token[counter++] = temp;
+        temp = MFeeprom.read_byte(addreeprom);
+    }
+    token[counter] = 0x00;
+    return true;
+}
+
+uint8_t CustomDeviceConfig::getNumbersFromEEPROM(uint16_t addreeprom, uint8_t *values, uint8_t count)
+{
+    char    token[MEMLEN_TOKEN_BUFFER];
+    uint8_t counter = 0;
+
+    for (; counter < count && getTokenFromEEPROM(addreeprom, token, sizeof(token)); counter++)
+        values[counter] = parseNumber(token, NULL);
+    for (uint8_t i = counter; i < count; i++)
+        values[i] = 0;
+    return counter;
+}
+
+unsigned long CustomDeviceConfig::parseNumber(const char *text, const char **end)
+{
+    char         *next  = (char *)text;
+    unsigned long value = 0;
+
+    // strtoul() would accept a sign and leading spaces, and a leading 0 as octal with base 0
+    if (text[0] >= '0' && text[0] <= '9') {
+        if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+            value = strtoul(text, &next, 16);
+        else
+            value = strtoul(text, &next, 10);
+    }
+    if (end)
+        *end = next;
+    return value;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+/* **********************************************************************************
+    The custom device pins, type and configuration is stored in the EEPROM.
+    The strings are '.' terminated, pins and parameters are delimited by "|".
+    They are evaluated in one pass while reading them from the EEPROM, so there is
+    no limit for the length of the strings. Only a single parameter is limited
+    to MEMLEN_TOKEN_BUFFER - 1 characters, longer ones get truncated.
+    These helpers are shared by all MFCustomDevice.cpp, add this folder to the
+    build_src_filter of the platformio.ini.
+********************************************************************************** */
+#define MEMLEN_TOKEN_BUFFER 24
+
+class CustomDeviceConfig
+{
+public:
+    // compares the '.' terminated string in the EEPROM at given address with a string in PROGMEM
+    static bool compareStringFromEEPROM(uint16_t addreeprom, const char *text);
+    // reads the next "|" delimited parameter and moves the address behind it
+    // returns false if the end of the string is reached
+    static bool getTokenFromEEPROM(uint16_t &addreeprom, char *token, uint8_t size);
+    // reads up to count "|" delimited numbers, missing or invalid ones are set to 0
+    // returns the number of values read
+    static uint8_t getNumbersFromEEPROM(uint16_t addreeprom, uint8_t *values, uint8_t count);
+    // parses a decimal number, also with leading zeros (e.g. "08"), or a hex number with 0x
+    // end is set behind the number, it is set to text if there is no number
+    static unsigned long parseNumber(const char *text, const char **end);
+};
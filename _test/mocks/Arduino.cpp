@@ -0,0 +1,149 @@
+#include "Arduino.h"
+#include <vector>
+
+#define MAX_LISTENERS 8
+
+namespace
+{
+    struct Listener {
+        ArduinoMock::PinListener function;
+        void                    *context;
+    };
+
+    uint64_t                           timeNs;
+    uint32_t                           writeCostNs;
+    uint8_t                            values[ArduinoMock::MAX_PINS];
+    uint8_t                            inputs[ArduinoMock::MAX_PINS];
+    uint8_t                            modes[ArduinoMock::MAX_PINS];
+    std::vector<ArduinoMock::PinEvent> eventLog;
+    Listener                           listeners[MAX_LISTENERS];
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < ArduinoMock::MAX_PINS)
+        modes[pin] = mode;
+}
+
+// Only changes are logged, writing the same value again takes the time but is no edge
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    timeNs += writeCostNs;
+    if (pin >= ArduinoMock::MAX_PINS || values[pin] == (value != LOW))
+        return;
+    values[pin] = value != LOW;
+
+    ArduinoMock::PinEvent event = {timeNs, pin, values[pin]};
+    eventLog.push_back(event);
+    for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+        if (listeners[i].function)
+            listeners[i].function(event, listeners[i].context);
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= ArduinoMock::MAX_PINS)
+        return LOW;
+    return modes[pin] == OUTPUT ? values[pin] : inputs[pin];
+}
+
+void delay(unsigned long ms)
+{
+    timeNs += (uint64_t)ms * 1000000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    timeNs += (uint64_t)us * 1000;
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(timeNs / 1000);
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(timeNs / 1000000);
+}
+
+namespace ArduinoMock
+{
+    void reset()
+    {
+        timeNs      = 0;
+        writeCostNs = 0;
+        memset(values, LOW, sizeof(values));
+        memset(inputs, LOW, sizeof(inputs));
+        memset(modes, INPUT, sizeof(modes));
+        memset(listeners, 0, sizeof(listeners));
+        eventLog.clear();
+    }
+
+    uint64_t now()
+    {
+        return timeNs;
+    }
+
+    void advance(uint64_t ns)
+    {
+        timeNs += ns;
+    }
+
+    void setWriteCost(uint32_t ns)
+    {
+        writeCostNs = ns;
+    }
+
+    uint8_t pinValue(uint8_t pin)
+    {
+        return pin < MAX_PINS ? values[pin] : LOW;
+    }
+
+    uint8_t pinModeOf(uint8_t pin)
+    {
+        return pin < MAX_PINS ? modes[pin] : INPUT;
+    }
+
+    void setInput(uint8_t pin, uint8_t value)
+    {
+        if (pin < MAX_PINS)
+            inputs[pin] = value != LOW;
+    }
+
+    const PinEvent *events()
+    {
+        return eventLog.data();
+    }
+
+    uint32_t eventCount()
+    {
+        return eventLog.size();
+    }
+
+    void clearLog()
+    {
+        eventLog.clear();
+    }
+
+    bool addListener(PinListener listener, void *context)
+    {
+        for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+            if (!listeners[i].function) {
+                listeners[i].function = listener;
+                listeners[i].context  = context;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void removeListener(PinListener listener, void *context)
+    {
+        for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+            if (listeners[i].function == listener && listeners[i].context == context)
+                listeners[i].function = nullptr;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+/* **********************************************************************************
+    Replacement of the Arduino core for the host build, see _test/README.md
+    Only the functions which are used by the custom devices are provided.
+    The pins and the time are simulated. The time advances only by delay(),
+    delayMicroseconds() and ArduinoMock::advance(), so the bit banging of a
+    driver takes the same simulated time on each run. Each change of an
+    output pin is logged with this time.
+********************************************************************************** */
+
+#include <ctype.h>
+#include <math.h>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH         0x1
+#define LOW          0x0
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define PROGMEM
+#define PGM_P               const char *
+#define PSTR(s)             (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)  (*(void *const *)(addr))
+#define strcmp_P            strcmp
+#define strlen_P            strlen
+#define strcpy_P            strcpy
+#define memcpy_P            memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+// like the Arduino macros, but without evaluating the arguments twice
+template <class A, class B>
+inline auto min(A a, B b) -> decltype(a + b)
+{
+    return a < b ? a : b;
+}
+template <class A, class B>
+inline auto max(A a, B b) -> decltype(a + b)
+{
+    return a > b ? a : b;
+}
+
+inline bool isDigit(int c)
+{
+    return isdigit(c);
+}
+
+void          pinMode(uint8_t pin, uint8_t mode);
+void          digitalWrite(uint8_t pin, uint8_t value);
+int           digitalRead(uint8_t pin);
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+unsigned long micros();
+unsigned long millis();
+
+// interrupts are not simulated
+inline void cli() {}
+inline void sei() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+namespace ArduinoMock
+{
+    const uint8_t MAX_PINS = 70;
+
+    struct PinEvent {
+        uint64_t timeNs;
+        uint8_t  pin;
+        uint8_t  value;
+    };
+
+    // called for each change of an output pin, e.g. by a protocol decoder
+    typedef void (*PinListener)(const PinEvent &event, void *context);
+
+    // all pins LOW and INPUT, time 0, empty log, no listeners, no write cost
+    void     reset();
+    // simulated time in ns
+    uint64_t now();
+    void     advance(uint64_t ns);
+    // simulated duration of each digitalWrite(), 0 by default
+    void     setWriteCost(uint32_t ns);
+    uint8_t  pinValue(uint8_t pin);
+    uint8_t  pinModeOf(uint8_t pin);
+    // level of an input pin as it is returned by digitalRead()
+    void     setInput(uint8_t pin, uint8_t value);
+
+    // the log of the pin changes since reset() or clearLog()
+    const PinEvent *events();
+    uint32_t        eventCount();
+    void            clearLog();
+
+    bool addListener(PinListener listener, void *context);
+    void removeListener(PinListener listener, void *context);
+}
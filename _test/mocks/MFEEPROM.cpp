@@ -0,0 +1,54 @@
+#include "MFEEPROM.h"
+
+MFEEPROM MFeeprom;
+
+MFEEPROM::MFEEPROM()
+{
+    reset();
+}
+
+void MFEEPROM::init()
+{
+}
+
+uint16_t MFEEPROM::get_length()
+{
+    return MFEEPROM_SIZE;
+}
+
+// like the AVR EEPROM, reading beyond the end returns an erased byte
+char MFEEPROM::read_byte(uint16_t adr)
+{
+    if (adr >= MFEEPROM_SIZE)
+        return (char)0xFF;
+    return _data[adr];
+}
+
+bool MFEEPROM::write_byte(uint16_t adr, const char data)
+{
+    if (adr >= MFEEPROM_SIZE)
+        return false;
+    _data[adr] = data;
+    return true;
+}
+
+bool MFEEPROM::read_block(uint16_t adr, char data[], uint16_t len)
+{
+    if (adr + len > MFEEPROM_SIZE)
+        return false;
+    memcpy(data, &_data[adr], len);
+    return true;
+}
+
+bool MFEEPROM::write_block(uint16_t adr, const char data[], uint16_t len)
+{
+    if (adr + len > MFEEPROM_SIZE)
+        return false;
+    memcpy(&_data[adr], data, len);
+    return true;
+}
+
+void MFEEPROM::reset()
+{
+    memset(_data, 0xFF, sizeof(_data));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+/* **********************************************************************************
+    EEPROM of the host build, a RAM array which is erased (0xFF) by reset().
+    The tests write the pins, type and config strings of a custom device
+    with write_block() like the firmware stores them from the connector.
+********************************************************************************** */
+
+#include "Arduino.h"
+
+#define MFEEPROM_SIZE 4096
+
+class MFEEPROM
+{
+public:
+    MFEEPROM();
+    void     init();
+    uint16_t get_length();
+    char     read_byte(uint16_t adr);
+    bool     write_byte(uint16_t adr, const char data);
+    bool     read_block(uint16_t adr, char data[], uint16_t len);
+    bool     write_block(uint16_t adr, const char data[], uint16_t len);
+
+    // test helper
+    void reset();
+
+private:
+    char _data[MFEEPROM_SIZE];
+};
+
+extern MFEEPROM MFeeprom;
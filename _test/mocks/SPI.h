@@ -0,0 +1,29 @@
+#pragma once
+
+/* **********************************************************************************
+    SPI for the host build. The GNC255 accesses the display only by U8g2, which is
+    replaced by the mock in U8g2lib.h, so nothing is transferred here.
+********************************************************************************** */
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define MSBFIRST  1
+
+class SPISettings
+{
+public:
+    SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0) {}
+};
+
+class SPIClass
+{
+public:
+    void    begin() {}
+    void    end() {}
+    void    beginTransaction(SPISettings settings) {}
+    void    endTransaction() {}
+    uint8_t transfer(uint8_t data) { return 0; }
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,5 @@
+#include "U8g2lib.h"
+
+const uint8_t u8g2_font_logisoso22_tn[] = {0};
+const uint8_t u8g2_font_profont10_mr[]  = {0};
+const uint8_t u8g2_font_profont12_mr[]  = {0};
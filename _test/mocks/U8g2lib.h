@@ -0,0 +1,103 @@
+#pragma once
+
+/* **********************************************************************************
+    U8g2 of the host build. Nothing is drawn, but the transfers to the display are
+    counted, so the tests can check how many tiles and pages the GNC255 sends.
+    All glyphs are U8G2_MOCK_GLYPH_WIDTH pixels wide.
+********************************************************************************** */
+
+#include "Arduino.h"
+
+#define U8G2_R0               0
+#define U8G2_MOCK_GLYPH_WIDTH 6
+
+typedef int16_t u8g2_int_t;
+typedef struct {
+    uint8_t unused;
+} u8g2_t;
+
+extern const uint8_t u8g2_font_logisoso22_tn[];
+extern const uint8_t u8g2_font_profont10_mr[];
+extern const uint8_t u8g2_font_profont12_mr[];
+
+inline uint8_t u8g2_GetGlyphWidth(u8g2_t *u8g2, uint16_t encoding)
+{
+    return U8G2_MOCK_GLYPH_WIDTH;
+}
+
+class U8G2
+{
+public:
+    U8G2(uint8_t pages)
+        : _pages(pages) {}
+
+    bool       begin() { return true; }
+    void       clearBuffer() {}
+    void       setFont(const uint8_t *font) {}
+    void       setFontMode(uint8_t mode) {}
+    void       setDrawColor(uint8_t color) {}
+    void       setCursor(u8g2_int_t x, u8g2_int_t y) {}
+    void       drawBox(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h) {}
+    u8g2_int_t drawGlyph(u8g2_int_t x, u8g2_int_t y, uint16_t encoding) { return U8G2_MOCK_GLYPH_WIDTH; }
+    u8g2_int_t getStrWidth(const char *s) { return U8G2_MOCK_GLYPH_WIDTH * strlen(s); }
+    int8_t     getAscent() { return 16; }
+    int8_t     getDescent() { return -4; }
+    size_t     print(const char *s) { return strlen(s); }
+    u8g2_t    *getU8g2() { return &_u8g2; }
+
+    // the full buffer is 32 x 8 tiles
+    void sendBuffer()
+    {
+        _buffersSent++;
+        _tilesSent += 32 * 8;
+    }
+    void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) { _tilesSent += tw * th; }
+    void firstPage() { _page = 0; }
+    uint8_t nextPage()
+    {
+        _tilesSent += 32 * 8 / _pages;
+        return ++_page < _pages;
+    }
+
+    // test helpers
+    uint16_t getBuffersSent() { return _buffersSent; }
+    uint32_t getTilesSent() { return _tilesSent; }
+
+private:
+    u8g2_t   _u8g2;
+    uint8_t  _pages;
+    uint8_t  _page        = 0;
+    uint16_t _buffersSent = 0;
+    uint32_t _tilesSent   = 0;
+};
+
+// the buffer size is the same as in U8g2, so sizeof() of the GNC255 display is right
+class U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI : public U8G2
+{
+public:
+    U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI(uint8_t rotation, uint8_t cs, uint8_t dc, uint8_t reset)
+        : U8G2(1) {}
+
+private:
+    uint8_t _buffer[2048];
+};
+
+class U8G2_SSD1322_NHD_256X64_1_4W_HW_SPI : public U8G2
+{
+public:
+    U8G2_SSD1322_NHD_256X64_1_4W_HW_SPI(uint8_t rotation, uint8_t cs, uint8_t dc, uint8_t reset)
+        : U8G2(8) {}
+
+private:
+    uint8_t _buffer[256];
+};
+
+class U8G2_SSD1322_NHD_256X64_2_4W_HW_SPI : public U8G2
+{
+public:
+    U8G2_SSD1322_NHD_256X64_2_4W_HW_SPI(uint8_t rotation, uint8_t cs, uint8_t dc, uint8_t reset)
+        : U8G2(4) {}
+
+private:
+    uint8_t _buffer[512];
+};
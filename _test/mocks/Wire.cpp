@@ -0,0 +1,73 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+void TwoWire::begin()
+{
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+    _clock = clock;
+}
+
+void TwoWire::setWireTimeout(uint32_t timeout, bool reset)
+{
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _current.address  = address;
+    _current.length   = 0;
+    _current.overflow = false;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (_current.length >= BUFFER_LENGTH) {
+        _current.overflow = true;
+        return 0;
+    }
+    _current.data[_current.length++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+    size_t written = 0;
+    while (written < length && write(data[written]))
+        written++;
+    return written;
+}
+
+// 9 clocks per byte, the address byte included
+uint8_t TwoWire::endTransmission(bool stop)
+{
+    _current.result = _results[_current.address & 0x7F];
+    ArduinoMock::advance((uint64_t)(_current.length + 1) * 9 * 1000000000ull / _clock);
+    if (_count < MAX_TRANSACTIONS)
+        _transactions[_count++] = _current;
+    return _current.result;
+}
+
+void TwoWire::reset()
+{
+    _clock = 100000;
+    _count = 0;
+    memset(_results, 0, sizeof(_results));
+}
+
+void TwoWire::setResult(uint8_t address, uint8_t result)
+{
+    _results[address & 0x7F] = result;
+}
+
+uint8_t TwoWire::transactionCount()
+{
+    return _count;
+}
+
+const TwoWire::Transaction &TwoWire::transaction(uint8_t index)
+{
+    return _transactions[index];
+}
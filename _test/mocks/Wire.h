@@ -0,0 +1,51 @@
+#pragma once
+
+/* **********************************************************************************
+    Fake Wire for the host build, like the AVR Wire library with a transmit buffer
+    of BUFFER_LENGTH bytes. Bytes beyond it are dropped and write() returns 0.
+    Each transaction is recorded, endTransmission() returns the result which is
+    set for the address (0 by default) and advances the simulated time by the
+    bus time of the address and data bytes at the selected clock.
+********************************************************************************** */
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH    32
+#define WIRE_HAS_TIMEOUT
+
+class TwoWire
+{
+public:
+    struct Transaction {
+        uint8_t address;
+        uint8_t data[BUFFER_LENGTH];
+        uint8_t length;
+        uint8_t result;
+        bool    overflow; // more bytes than BUFFER_LENGTH were written
+    };
+
+    static const uint8_t MAX_TRANSACTIONS = 64;
+
+    void    begin();
+    void    setClock(uint32_t clock);
+    void    setWireTimeout(uint32_t timeout = 25000, bool reset = false);
+    void    beginTransmission(uint8_t address);
+    size_t  write(uint8_t data);
+    size_t  write(const uint8_t *data, size_t length);
+    uint8_t endTransmission(bool stop = true);
+
+    // test helpers
+    void               reset();
+    void               setResult(uint8_t address, uint8_t result);
+    uint8_t            transactionCount();
+    const Transaction &transaction(uint8_t index);
+
+private:
+    uint32_t    _clock = 100000;
+    uint8_t     _results[128];
+    Transaction _current;
+    Transaction _transactions[MAX_TRANSACTIONS];
+    uint8_t     _count = 0;
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,40 @@
+#include "allocateMem.h"
+#include <stddef.h>
+
+// aligned for the classes which are created in the buffer
+alignas(max_align_t) static uint8_t deviceBuffer[MF_MAX_DEVICEMEM];
+static uint16_t                     nextPointer = 0;
+static uint16_t                     limit       = MF_MAX_DEVICEMEM;
+
+// like in the firmware, returns nullptr if it does not fit, so check it with FitInMemory() before
+uint8_t *allocateMemory(uint16_t size)
+{
+    if (!FitInMemory(size))
+        return nullptr;
+    uint8_t *memory = &deviceBuffer[nextPointer];
+    // the next allocation is aligned as well
+    nextPointer = (nextPointer + size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    if (nextPointer > limit)
+        nextPointer = limit;
+    return memory;
+}
+
+void ClearMemory()
+{
+    nextPointer = 0;
+}
+
+uint16_t GetAvailableMemory()
+{
+    return limit - nextPointer;
+}
+
+bool FitInMemory(uint16_t size)
+{
+    return nextPointer + size <= limit;
+}
+
+void setMemoryLimit(uint16_t size)
+{
+    limit = size < MF_MAX_DEVICEMEM ? size : MF_MAX_DEVICEMEM;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+/* **********************************************************************************
+    Device buffer of the host build. Like in the firmware the devices get their
+    memory from one static buffer which is only released as a whole by
+    ClearMemory(). setMemoryLimit() simulates a smaller buffer, e.g. of the Uno.
+********************************************************************************** */
+
+#include <stdint.h>
+
+#ifndef MF_MAX_DEVICEMEM
+#define MF_MAX_DEVICEMEM 4000
+#endif
+
+uint8_t *allocateMemory(uint16_t size);
+void     ClearMemory();
+uint16_t GetAvailableMemory();
+bool     FitInMemory(uint16_t size);
+
+// test helper, the limit is kept by ClearMemory()
+void setMemoryLimit(uint16_t size);
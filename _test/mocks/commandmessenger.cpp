@@ -0,0 +1,76 @@
+#include "commandmessenger.h"
+
+CmdMessenger cmdMessenger;
+
+void CmdMessenger::sendCmd(uint8_t cmdId)
+{
+    sendCmdStart(cmdId);
+    sendCmdEnd();
+}
+
+void CmdMessenger::sendCmd(uint8_t cmdId, const char *arg)
+{
+    sendCmdStart(cmdId);
+    sendCmdArg(arg);
+    sendCmdEnd();
+}
+
+void CmdMessenger::sendCmd(uint8_t cmdId, const __FlashStringHelper *arg)
+{
+    sendCmd(cmdId, (const char *)arg);
+}
+
+void CmdMessenger::sendCmdStart(uint8_t cmdId)
+{
+    _current = std::to_string(cmdId);
+    _started = true;
+}
+
+void CmdMessenger::sendCmdArg(const char *arg)
+{
+    if (!_started)
+        return;
+    _current += ',';
+    _current += arg;
+}
+
+void CmdMessenger::sendCmdArg(const __FlashStringHelper *arg)
+{
+    sendCmdArg((const char *)arg);
+}
+
+// the oldest commands are dropped if there are more than fit
+void CmdMessenger::sendCmdEnd()
+{
+    if (!_started)
+        return;
+    _commands[_count % MAX_COMMANDS] = _current + ';';
+    _count++;
+    _started = false;
+}
+
+void CmdMessenger::clear()
+{
+    _count   = 0;
+    _started = false;
+}
+
+uint16_t CmdMessenger::count()
+{
+    return _count;
+}
+
+const std::string &CmdMessenger::last()
+{
+    static const std::string none;
+    return _count ? _commands[(_count - 1) % MAX_COMMANDS] : none;
+}
+
+bool CmdMessenger::contains(const char *text)
+{
+    for (uint16_t i = _count > MAX_COMMANDS ? _count - MAX_COMMANDS : 0; i < _count; i++) {
+        if (_commands[i % MAX_COMMANDS].find(text) != std::string::npos)
+            return true;
+    }
+    return false;
+}
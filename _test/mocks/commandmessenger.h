@@ -0,0 +1,54 @@
+#pragma once
+
+/* **********************************************************************************
+    CmdMessenger of the host build. The commands are not sent but recorded in
+    the same text format as on the serial line: "command,arg,arg;", so the
+    tests can check the status messages of the devices.
+********************************************************************************** */
+
+#include "Arduino.h"
+#include <string>
+
+// same numbers as in the firmware
+enum {
+    kInitModule,
+    kSetModule,
+    kSetPin,
+    kSetStepper,
+    kSetServo,
+    kStatus
+};
+
+class CmdMessenger
+{
+public:
+    void sendCmd(uint8_t cmdId);
+    void sendCmd(uint8_t cmdId, const char *arg);
+    void sendCmd(uint8_t cmdId, const __FlashStringHelper *arg);
+    void sendCmdStart(uint8_t cmdId);
+    void sendCmdArg(const char *arg);
+    void sendCmdArg(const __FlashStringHelper *arg);
+    void sendCmdArg(char *arg) { sendCmdArg((const char *)arg); }
+    template <class T>
+    void sendCmdArg(T arg)
+    {
+        sendCmdArg(std::to_string(arg).c_str());
+    }
+    void sendCmdEnd();
+
+    static const uint8_t MAX_COMMANDS = 32;
+
+    // test helpers, all commands since the last clear()
+    void               clear();
+    uint16_t           count();
+    const std::string &last();
+    bool               contains(const char *text);
+
+private:
+    std::string _commands[MAX_COMMANDS];
+    uint16_t    _count   = 0;
+    bool        _started = false;
+    std::string _current;
+};
+
+extern CmdMessenger cmdMessenger;
@@ -0,0 +1,313 @@
+#include "HT1621Decoder.h"
+
+#define MODE_BITS    3
+#define ADDRESS_BITS 6
+#define COMMAND_BITS 9
+#define NIBBLE_BITS  4
+
+HT1621Decoder::HT1621Decoder(uint8_t cs, uint8_t wr, uint8_t data, Supply supply)
+{
+    _csPin      = cs;
+    _wrPin      = wr;
+    _dataPin    = data;
+    _minClockNs = supply == VDD_3V ? HT1621::MIN_CLK_WIDTH_3V_NS : HT1621::MIN_CLK_WIDTH_5V_NS;
+    _wr         = ArduinoMock::pinValue(wr);
+    _data       = ArduinoMock::pinValue(data);
+    reset();
+    ArduinoMock::addListener(onPinChange, this);
+}
+
+HT1621Decoder::~HT1621Decoder()
+{
+    ArduinoMock::removeListener(onPinChange, this);
+}
+
+void HT1621Decoder::reset()
+{
+    memset(_ram, 0, sizeof(_ram));
+    _systemEnabled = false;
+    _lcdOn         = false;
+    _toneOn        = false;
+    _bias          = 0;
+    _oscillator    = 0;
+    _lastCommand   = 0;
+    _inFrame       = false;
+    resetStatistics();
+}
+
+void HT1621Decoder::resetStatistics()
+{
+    _commandFrames    = 0;
+    _writeFrames      = 0;
+    _readFrames       = 0;
+    _incompleteFrames = 0;
+    _bits             = 0;
+    _busTimeNs        = 0;
+    memset(_violations, 0, sizeof(_violations));
+}
+
+void HT1621Decoder::onPinChange(const ArduinoMock::PinEvent &event, void *context)
+{
+    static_cast<HT1621Decoder *>(context)->pinChanged(event);
+}
+
+// The HT1621 only listens while CS is low, WR and DATA are ignored otherwise
+void HT1621Decoder::pinChanged(const ArduinoMock::PinEvent &event)
+{
+    if (event.pin == _csPin) {
+        if (event.value == LOW)
+            frameStart(event.timeNs);
+        else if (_inFrame)
+            frameEnd(event.timeNs);
+    } else if (event.pin == _wrPin) {
+        _wr = event.value;
+        if (!_inFrame)
+            return;
+        if (_wr == LOW)
+            clockFalling(event.timeNs);
+        else
+            clockRising(event.timeNs);
+    } else if (event.pin == _dataPin) {
+        _data = event.value;
+        if (!_inFrame)
+            return;
+        if (_wrRiseNs && event.timeNs - _wrRiseNs < HT1621::MIN_DATA_HOLD_NS)
+            violation(DATA_HOLD);
+        _dataChangeNs = event.timeNs;
+    }
+}
+
+void HT1621Decoder::frameStart(uint64_t timeNs)
+{
+    _inFrame      = true;
+    _mode         = MODE_NONE;
+    _shift        = 0;
+    _count        = 0;
+    _address      = 0;
+    _addressDone  = false;
+    _frameStartNs = timeNs;
+    _wrFallNs     = 0;
+    _wrRiseNs     = 0;
+    _dataChangeNs = 0;
+}
+
+// A frame is complete if it ends after a whole command or a whole nibble
+void HT1621Decoder::frameEnd(uint64_t timeNs)
+{
+    _inFrame = false;
+    _busTimeNs += timeNs - _frameStartNs;
+
+    bool complete = false;
+    switch (_mode) {
+    case MODE_COMMAND:
+        _commandFrames++;
+        complete = _count == 0;
+        break;
+    case MODE_WRITE:
+        _writeFrames++;
+        complete = _addressDone && _count == 0;
+        break;
+    case MODE_READ:
+        _readFrames++;
+        complete = _addressDone && _count == 0;
+        break;
+    default:
+        break;
+    }
+    if (!complete)
+        _incompleteFrames++;
+}
+
+void HT1621Decoder::clockFalling(uint64_t timeNs)
+{
+    if (_wrRiseNs && timeNs - _wrRiseNs < _minClockNs)
+        violation(WR_HIGH_WIDTH);
+    _wrFallNs = timeNs;
+
+    // RD and WR are one pin on the KAV boards, the HT1621 puts the next bit on DATA with the falling edge
+    if (_mode == MODE_READ && _addressDone)
+        ArduinoMock::setInput(_dataPin, (_ram[_address] >> _count) & 1);
+}
+
+// DATA is latched with the rising edge
+void HT1621Decoder::clockRising(uint64_t timeNs)
+{
+    if (_wrFallNs && timeNs - _wrFallNs < _minClockNs)
+        violation(WR_LOW_WIDTH);
+    if (_dataChangeNs && timeNs - _dataChangeNs < HT1621::MIN_DATA_SETUP_NS)
+        violation(DATA_SETUP);
+    _wrRiseNs = timeNs;
+
+    _bits++;
+    receiveBit(_data);
+}
+
+void HT1621Decoder::receiveBit(uint8_t bit)
+{
+    if (_mode == MODE_NONE) {
+        _shift = (_shift << 1) | bit;
+        if (++_count < MODE_BITS)
+            return;
+        if (_shift == HT1621::COMMAND_MODE >> 5)
+            _mode = MODE_COMMAND;
+        else if (_shift == HT1621::WRITE_MODE >> 5)
+            _mode = MODE_WRITE;
+        else if (_shift == HT1621::READ_MODE >> 5)
+            _mode = MODE_READ;
+        else
+            _mode = MODE_INVALID;
+        _shift = 0;
+        _count = 0;
+        return;
+    }
+
+    switch (_mode) {
+    case MODE_COMMAND:
+        _shift = (_shift << 1) | bit;
+        if (++_count == COMMAND_BITS) {
+            command(_shift);
+            _shift = 0;
+            _count = 0;
+        }
+        break;
+    case MODE_WRITE:
+    case MODE_READ:
+        if (!_addressDone) {
+            _shift = (_shift << 1) | bit;
+            if (++_count == ADDRESS_BITS) {
+                _address     = _shift % HT1621::MAX_ADDR;
+                _addressDone = true;
+                _shift       = 0;
+                _count       = 0;
+            }
+            break;
+        }
+        // the nibbles are sent LSB first
+        if (_mode == MODE_WRITE)
+            _shift |= bit << _count;
+        if (++_count == NIBBLE_BITS) {
+            if (_mode == MODE_WRITE)
+                _ram[_address] = _shift;
+            _address = (_address + 1) % HT1621::MAX_ADDR;
+            _shift   = 0;
+            _count   = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* **********************************************************************************
+    The command code is C8..C0 of the datasheet. The codes of HT1621::Commands are
+    C7..C0, C8 is the 4th bit of COMMAND_MODE. The don't care bits are masked.
+********************************************************************************** */
+void HT1621Decoder::command(uint8_t cmd)
+{
+    cmd &= 0xFE;
+    _lastCommand = cmd;
+
+    if (cmd == HT1621::SYS_DIS || cmd == HT1621::SYS_EN)
+        _systemEnabled = cmd == HT1621::SYS_EN;
+    else if (cmd == HT1621::LCD_OFF || cmd == HT1621::LCD_ON)
+        _lcdOn = cmd == HT1621::LCD_ON;
+    else if (cmd == HT1621::TONE_OFF || cmd == HT1621::TONE_ON)
+        _toneOn = cmd == HT1621::TONE_ON;
+    else if ((cmd & 0xE0) == HT1621::BIAS_HALF_2_COM)
+        _bias = cmd & ~0x04;
+    else if ((cmd & 0xF8) == HT1621::RC256K || (cmd & 0xF8) == HT1621::XTAL32K || (cmd & 0xF8) == HT1621::EXT256K)
+        _oscillator = cmd & 0xF8;
+}
+
+void HT1621Decoder::violation(Violations type)
+{
+    _violations[type]++;
+}
+
+uint8_t HT1621Decoder::ram(uint8_t address)
+{
+    return _ram[address % HT1621::MAX_ADDR];
+}
+
+uint8_t HT1621Decoder::ramByte(uint8_t address)
+{
+    return ram(address) | (ram(address + 1) << 4);
+}
+
+bool HT1621Decoder::systemEnabled()
+{
+    return _systemEnabled;
+}
+
+bool HT1621Decoder::lcdOn()
+{
+    return _lcdOn;
+}
+
+bool HT1621Decoder::toneOn()
+{
+    return _toneOn;
+}
+
+uint8_t HT1621Decoder::bias()
+{
+    return _bias;
+}
+
+uint8_t HT1621Decoder::oscillator()
+{
+    return _oscillator;
+}
+
+uint8_t HT1621Decoder::lastCommand()
+{
+    return _lastCommand;
+}
+
+uint16_t HT1621Decoder::getCommandFrames()
+{
+    return _commandFrames;
+}
+
+uint16_t HT1621Decoder::getWriteFrames()
+{
+    return _writeFrames;
+}
+
+uint16_t HT1621Decoder::getReadFrames()
+{
+    return _readFrames;
+}
+
+uint16_t HT1621Decoder::getFrames()
+{
+    return _commandFrames + _writeFrames + _readFrames;
+}
+
+uint16_t HT1621Decoder::getIncompleteFrames()
+{
+    return _incompleteFrames;
+}
+
+uint32_t HT1621Decoder::getBitsReceived()
+{
+    return _bits;
+}
+
+uint64_t HT1621Decoder::getBusTimeNs()
+{
+    return _busTimeNs;
+}
+
+uint16_t HT1621Decoder::getViolations(Violations type)
+{
+    return _violations[type];
+}
+
+uint16_t HT1621Decoder::getViolations()
+{
+    uint16_t count = 0;
+    for (uint8_t i = 0; i < VIOLATION_TYPES; i++)
+        count += _violations[i];
+    return count;
+}
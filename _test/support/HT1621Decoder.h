@@ -0,0 +1,115 @@
+#pragma once
+
+/* **********************************************************************************
+    Model of the HT1621 for the host build. It watches the CS, WR and DATA pins of
+    the Arduino mock and decodes the frames like the chip does:
+    - COMMAND frames (100 + 9 bit commands) change the command state
+    - WRITE frames (101 + 6 bit address + nibbles) change the 32 nibbles of the RAM,
+      the address increments after each nibble
+    - READ frames (110 + 6 bit address) drive DATA with the RAM from the falling
+      edge of WR, see ArduinoMock::setInput()
+    The time between the edges is checked against the timing model in HT1621.h,
+    each clock or data change which is too short is counted as a violation.
+********************************************************************************** */
+
+#include "Arduino.h"
+#include "../../KAV_Simulation/EFIS_FCU/HT1621.h"
+
+class HT1621Decoder
+{
+public:
+    enum Supply {
+        VDD_3V,
+        VDD_5V
+    };
+
+    enum Violations {
+        WR_LOW_WIDTH,
+        WR_HIGH_WIDTH,
+        DATA_SETUP,
+        DATA_HOLD,
+        VIOLATION_TYPES
+    };
+
+    HT1621Decoder(uint8_t cs, uint8_t wr, uint8_t data, Supply supply = VDD_5V);
+    ~HT1621Decoder();
+
+    // RAM and command state like after power on, the statistics are reset as well
+    void reset();
+    void resetStatistics();
+
+    uint8_t ram(uint8_t address);
+    // the byte of two successive nibbles, the lower address is the low nibble like HT1621::write()
+    uint8_t ramByte(uint8_t address);
+
+    bool    systemEnabled();
+    bool    lcdOn();
+    bool    toneOn();
+    uint8_t bias();       // command code of the last BIAS command, 0 if none was received
+    uint8_t oscillator(); // RC256K, XTAL_32K or EXT_256K, 0 if none was received
+    uint8_t lastCommand();
+
+    uint16_t getCommandFrames();
+    uint16_t getWriteFrames();
+    uint16_t getReadFrames();
+    uint16_t getFrames();
+    uint16_t getIncompleteFrames(); // CS released within the mode, the address, a command or a nibble
+    uint32_t getBitsReceived();
+    uint64_t getBusTimeNs(); // CS low
+    uint16_t getViolations(Violations type);
+    uint16_t getViolations();
+
+private:
+    enum Modes {
+        MODE_NONE,
+        MODE_COMMAND,
+        MODE_WRITE,
+        MODE_READ,
+        MODE_INVALID
+    };
+
+    static void onPinChange(const ArduinoMock::PinEvent &event, void *context);
+    void        pinChanged(const ArduinoMock::PinEvent &event);
+    void        frameStart(uint64_t timeNs);
+    void        frameEnd(uint64_t timeNs);
+    void        clockFalling(uint64_t timeNs);
+    void        clockRising(uint64_t timeNs);
+    void        receiveBit(uint8_t bit);
+    void        command(uint8_t cmd);
+    void        violation(Violations type);
+
+    uint8_t  _csPin;
+    uint8_t  _wrPin;
+    uint8_t  _dataPin;
+    uint16_t _minClockNs;
+    uint8_t  _wr;
+    uint8_t  _data;
+
+    uint8_t _ram[HT1621::MAX_ADDR];
+    bool    _systemEnabled;
+    bool    _lcdOn;
+    bool    _toneOn;
+    uint8_t _bias;
+    uint8_t _oscillator;
+    uint8_t _lastCommand;
+
+    // state of the current frame, the times are 0 if the edge was not within the frame
+    bool     _inFrame;
+    Modes    _mode;
+    uint16_t _shift;
+    uint8_t  _count;
+    uint8_t  _address;
+    bool     _addressDone;
+    uint64_t _frameStartNs;
+    uint64_t _wrFallNs;
+    uint64_t _wrRiseNs;
+    uint64_t _dataChangeNs;
+
+    uint16_t _commandFrames;
+    uint16_t _writeFrames;
+    uint16_t _readFrames;
+    uint16_t _incompleteFrames;
+    uint32_t _bits;
+    uint64_t _busTimeNs;
+    uint16_t _violations[VIOLATION_TYPES];
+};
@@ -0,0 +1,92 @@
+#include <unity.h>
+#include "MFCustomDevice.h"
+#include "MFEEPROM.h"
+#include "Wire.h"
+#include "allocateMem.h"
+#include "commandmessenger.h"
+
+// two devices, like the firmware stores them one after the other
+#define ADR_FCU 0
+#define ADR_I2C 100
+
+static void writeConfig(uint16_t adr, const char *pins, const char *type, const char *config)
+{
+    MFeeprom.write_block(adr, pins, strlen(pins));
+    MFeeprom.write_block(adr + 20, type, strlen(type));
+    MFeeprom.write_block(adr + 60, config, strlen(config));
+}
+
+MFCustomDevice *fcu;
+MFCustomDevice *i2c;
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    MFeeprom.reset();
+    ClearMemory();
+    cmdMessenger.clear();
+    Wire.reset();
+    writeConfig(ADR_FCU, "4|2|3.", "KAV_FCU.", ".");
+    writeConfig(ADR_I2C, "0x20.", "MOBIFLIGHT_GENERICI2C.", "0.");
+    fcu = new MFCustomDevice(ADR_FCU, ADR_FCU + 20, ADR_FCU + 60);
+    i2c = new MFCustomDevice(ADR_I2C, ADR_I2C + 20, ADR_I2C + 60);
+}
+
+void tearDown(void)
+{
+    fcu->detach();
+    i2c->detach();
+    delete fcu;
+    delete i2c;
+}
+
+void test_devices_from_eeprom(void)
+{
+    TEST_ASSERT_EQUAL(0, cmdMessenger.count());
+    i2c->set(1, (char *)"5");
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+}
+
+// with MF_CUSTOMDEVICE_MAILBOX the FCU is written from update(), only the latest value
+void test_mailbox(void)
+{
+    ArduinoMock::clearLog();
+    fcu->set(2, (char *)"100");
+    fcu->set(2, (char *)"200");
+    TEST_ASSERT_EQUAL(0, ArduinoMock::eventCount());
+    TEST_ASSERT_EQUAL(1, fcu->getMailboxDepth());
+    TEST_ASSERT_EQUAL(1, fcu->getMailboxOverwritten());
+
+    fcu->update();
+    TEST_ASSERT_GREATER_THAN(0, ArduinoMock::eventCount());
+    TEST_ASSERT_EQUAL(0, fcu->getMailboxDepth());
+}
+
+// each line of the profile is tagged with the device type and the index of the device
+void test_profile_report(void)
+{
+    fcu->set(2, (char *)"100");
+    fcu->update();
+    i2c->set(1, (char *)"5");
+
+    cmdMessenger.clear();
+    fcu->set(MESSAGEID_DIAGNOSTICS, (char *)"1");
+    TEST_ASSERT_TRUE(cmdMessenger.contains("Profile,KAV_FCU,0,messageID,2,"));
+    // without HT1621_ASYNC the FCU does not need update()
+    TEST_ASSERT_FALSE(cmdMessenger.contains("Profile,KAV_FCU,0,update(),"));
+
+    cmdMessenger.clear();
+    i2c->set(MESSAGEID_DIAGNOSTICS, (char *)"1");
+    TEST_ASSERT_TRUE(cmdMessenger.contains("Profile,MOBIFLIGHT_GENERICI2C,1,messageID,1,"));
+    // and the bus statistics of the generic I2C device
+    TEST_ASSERT_TRUE(cmdMessenger.contains("I2C address,32,"));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_devices_from_eeprom);
+    RUN_TEST(test_mailbox);
+    RUN_TEST(test_profile_report);
+    return UNITY_END();
+}
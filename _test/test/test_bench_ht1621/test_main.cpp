@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <stdio.h>
+#include "HT1621.h"
+#include "HT1621Fixed.h"
+
+/* **********************************************************************************
+    Time of HT1621::write() with 8 bits (17 clocks) for each timing profile,
+    measured with micros(), with the pins given at runtime and with HT1621Fixed.
+    On a board this is the bus time plus the overhead of the PinIO backend, no
+    display has to be connected. In the host build the time is simulated, so it
+    is exactly the bus time and this only checks the benchmark.
+********************************************************************************** */
+
+#define WRITES 200
+
+#if defined(HT1621_PINIO_AVR)
+#define BACKEND "AVR port registers"
+#elif defined(HT1621_PINIO_RP2040)
+#define BACKEND "RP2040 SIO"
+#else
+#define BACKEND "digitalWrite()"
+#endif
+
+struct PinSet {
+    const char *name;
+    uint8_t     cs;
+    uint8_t     wr;
+    uint8_t     data;
+};
+
+#if defined(__AVR_ATmega2560__)
+// the ports A to G are changed with one store, H to L with interrupts disabled
+static const PinSet pinSets[] = {{"port A", 22, 23, 24}, {"port H", 7, 8, 9}};
+#else
+static const PinSet pinSets[] = {{"GPIO", 2, 3, 4}};
+#endif
+
+static const HT1621::TimingProfiles profiles[]     = {HT1621::TIMING_LEGACY, HT1621::TIMING_3V, HT1621::TIMING_5V};
+static const char                  *profileNames[] = {"TIMING_LEGACY", "TIMING_3V", "TIMING_5V"};
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void measure(HT1621 &ht, const char *variant, const char *pins)
+{
+    char line[120];
+
+    ht.begin();
+    for (uint8_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        ht.setTiming(profiles[i]);
+        ht.resetStatistics();
+
+        uint32_t start = micros();
+        for (uint16_t n = 0; n < WRITES; n++)
+            ht.write(0, n, 8);
+        uint32_t elapsed = micros() - start;
+
+        // in 1/100 us
+        unsigned long measured = elapsed * 100 / WRITES;
+        unsigned long busTime  = ht.getBusTime() * 100 / WRITES;
+        snprintf(line, sizeof(line), "%s, %s, %s, %s: %lu.%02lu us per write, bus time %lu.%02lu us", BACKEND, variant, pins,
+                 profileNames[i], measured / 100, measured % 100, busTime / 100, busTime % 100);
+        TEST_MESSAGE(line);
+#if !defined(ARDUINO_ARCH_AVR) && !defined(ARDUINO_ARCH_RP2040)
+        TEST_ASSERT_EQUAL(busTime, measured);
+#endif
+    }
+}
+
+void test_us_per_write(void)
+{
+    for (uint8_t p = 0; p < sizeof(pinSets) / sizeof(pinSets[0]); p++) {
+        HT1621 ht(pinSets[p].cs, pinSets[p].wr, pinSets[p].data);
+        measure(ht, "runtime pins", pinSets[p].name);
+    }
+}
+
+// the same pins as pinSets[]
+void test_us_per_write_fixed(void)
+{
+#if defined(__AVR_ATmega2560__)
+    HT1621Fixed<22, 23, 24> portA;
+    HT1621Fixed<7, 8, 9>    portH;
+    measure(portA, "HT1621Fixed", pinSets[0].name);
+    measure(portH, "HT1621Fixed", pinSets[1].name);
+#else
+    HT1621Fixed<2, 3, 4> gpio;
+    measure(gpio, "HT1621Fixed", pinSets[0].name);
+#endif
+}
+
+#if defined(ARDUINO_ARCH_AVR) || defined(ARDUINO_ARCH_RP2040)
+void setup()
+{
+    delay(2000); // the serial monitor of PlatformIO connects after the reset
+    UNITY_BEGIN();
+    RUN_TEST(test_us_per_write);
+    RUN_TEST(test_us_per_write_fixed);
+    UNITY_END();
+}
+
+void loop()
+{
+}
+#else
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_us_per_write);
+    RUN_TEST(test_us_per_write_fixed);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,88 @@
+#include <unity.h>
+#include "MFEEPROM.h"
+#include "../../../_common/CustomDeviceConfig.h"
+
+void setUp(void)
+{
+    MFeeprom.reset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_parse_number(void)
+{
+    const char *end;
+
+    TEST_ASSERT_EQUAL(33, CustomDeviceConfig::parseNumber("33", &end));
+    TEST_ASSERT_EQUAL(0, *end);
+    TEST_ASSERT_EQUAL(8, CustomDeviceConfig::parseNumber("08", &end));
+    TEST_ASSERT_EQUAL(0x21, CustomDeviceConfig::parseNumber("0x21-0x24", &end));
+    TEST_ASSERT_EQUAL('-', *end);
+    TEST_ASSERT_EQUAL(0x7F, CustomDeviceConfig::parseNumber("0X7f", &end));
+}
+
+void test_parse_number_without_digit(void)
+{
+    const char *text = " 5";
+    const char *end;
+
+    TEST_ASSERT_EQUAL(0, CustomDeviceConfig::parseNumber(text, &end));
+    TEST_ASSERT_TRUE(end == text);
+    text = "-5";
+    CustomDeviceConfig::parseNumber(text, &end);
+    TEST_ASSERT_TRUE(end == text);
+}
+
+void test_compare_string(void)
+{
+    MFeeprom.write_block(10, "KAV_FCU.", 8);
+
+    TEST_ASSERT_TRUE(CustomDeviceConfig::compareStringFromEEPROM(10, "KAV_FCU"));
+    TEST_ASSERT_FALSE(CustomDeviceConfig::compareStringFromEEPROM(10, "KAV_FCUX"));
+    TEST_ASSERT_FALSE(CustomDeviceConfig::compareStringFromEEPROM(10, "KAV_FC"));
+}
+
+// the last string in the EEPROM may end at an erased byte instead of '.'
+void test_tokens(void)
+{
+    char     token[MEMLEN_TOKEN_BUFFER];
+    uint16_t adr = 0;
+
+    MFeeprom.write_block(0, "1|0x22||4", 9);
+
+    TEST_ASSERT_TRUE(CustomDeviceConfig::getTokenFromEEPROM(adr, token, sizeof(token)));
+    TEST_ASSERT_EQUAL_STRING("1", token);
+    TEST_ASSERT_TRUE(CustomDeviceConfig::getTokenFromEEPROM(adr, token, sizeof(token)));
+    TEST_ASSERT_EQUAL_STRING("0x22", token);
+    TEST_ASSERT_TRUE(CustomDeviceConfig::getTokenFromEEPROM(adr, token, sizeof(token)));
+    TEST_ASSERT_EQUAL_STRING("", token);
+    TEST_ASSERT_TRUE(CustomDeviceConfig::getTokenFromEEPROM(adr, token, sizeof(token)));
+    TEST_ASSERT_EQUAL_STRING("4", token);
+    TEST_ASSERT_FALSE(CustomDeviceConfig::getTokenFromEEPROM(adr, token, sizeof(token)));
+}
+
+void test_numbers(void)
+{
+    uint8_t values[4];
+
+    MFeeprom.write_block(0, "5|6|7.", 6);
+
+    TEST_ASSERT_EQUAL(3, CustomDeviceConfig::getNumbersFromEEPROM(0, values, 4));
+    TEST_ASSERT_EQUAL(5, values[0]);
+    TEST_ASSERT_EQUAL(6, values[1]);
+    TEST_ASSERT_EQUAL(7, values[2]);
+    TEST_ASSERT_EQUAL(0, values[3]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_number);
+    RUN_TEST(test_parse_number_without_digit);
+    RUN_TEST(test_compare_string);
+    RUN_TEST(test_tokens);
+    RUN_TEST(test_numbers);
+    return UNITY_END();
+}
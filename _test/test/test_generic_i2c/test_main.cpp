@@ -0,0 +1,138 @@
+#include <unity.h>
+#include "MFCustomDevice.h"
+#include "MFEEPROM.h"
+#include "Wire.h"
+#include "allocateMem.h"
+#include "commandmessenger.h"
+
+#define ADR_PINS   0
+#define ADR_TYPE   20
+#define ADR_CONFIG 60
+
+static void writeConfig(const char *pins, const char *config)
+{
+    MFeeprom.write_block(ADR_PINS, pins, strlen(pins));
+    MFeeprom.write_block(ADR_TYPE, "MOBIFLIGHT_GENERICI2C.", 22);
+    MFeeprom.write_block(ADR_CONFIG, config, strlen(config));
+}
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    MFeeprom.reset();
+    ClearMemory();
+    cmdMessenger.clear();
+    Wire.reset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_text_protocol(void)
+{
+    writeConfig("0x20.", "0.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(3, (char *)"abc");
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+    TEST_ASSERT_EQUAL_HEX8(0x20, Wire.transaction(0).address);
+    TEST_ASSERT_EQUAL(4, Wire.transaction(0).length);
+    TEST_ASSERT_EQUAL_MEMORY("\x03" "abc", Wire.transaction(0).data, 4);
+}
+
+// the messageID and the text must fit into the transmit buffer of the Wire library
+void test_text_is_truncated_to_the_wire_buffer(void)
+{
+    char text[41];
+
+    writeConfig("0x20.", "0.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+    memset(text, 'x', 40);
+    text[40] = 0x00;
+
+    device.set(3, text);
+    TEST_ASSERT_EQUAL(BUFFER_LENGTH, Wire.transaction(0).length);
+    TEST_ASSERT_FALSE(Wire.transaction(0).overflow);
+}
+
+void test_address_range(void)
+{
+    writeConfig("0x20.", "0|0|0|0|0x21-0x22.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(1, (char *)"5");
+    TEST_ASSERT_EQUAL(3, Wire.transactionCount());
+    TEST_ASSERT_EQUAL_HEX8(0x20, Wire.transaction(0).address);
+    TEST_ASSERT_EQUAL_HEX8(0x21, Wire.transaction(1).address);
+    TEST_ASSERT_EQUAL_HEX8(0x22, Wire.transaction(2).address);
+}
+
+void test_invalid_address_list(void)
+{
+    writeConfig("0x20.", "0|0|0|0|0x22-0x21.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    TEST_ASSERT_EQUAL_STRING("5,I2C address list is not valid;", cmdMessenger.last().c_str());
+    device.set(1, (char *)"5");
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+}
+
+// a NACK is retried from update() up to the configured number of retries
+void test_retry_and_diagnostics(void)
+{
+    writeConfig("0x20.", "0|0|2|100.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+    Wire.setResult(0x20, 2);
+
+    device.set(1, (char *)"5");
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+    device.update();
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+    for (uint8_t i = 0; i < 4; i++) {
+        delay(1);
+        device.update();
+    }
+    TEST_ASSERT_EQUAL(3, Wire.transactionCount());
+    device.set(GENERICI2C_MESSAGEID_DIAGNOSTICS, (char *)"1");
+    TEST_ASSERT_TRUE(cmdMessenger.contains("Transactions,3,Bytes,0,NACKs,3,Timeouts,0,Errors,0,Retries,2,"));
+}
+
+// queued values are sent by update(), only the latest value of each messageID
+void test_queue(void)
+{
+    writeConfig("0x20.", "0|1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(1, (char *)"5");
+    device.set(1, (char *)"6");
+    TEST_ASSERT_EQUAL(0, Wire.transactionCount());
+    device.update();
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+    TEST_ASSERT_EQUAL_MEMORY("\x01" "6", Wire.transaction(0).data, 2);
+}
+
+void test_queue_does_not_fit(void)
+{
+    setMemoryLimit(sizeof(GenericI2C) + 16);
+    writeConfig("0x20.", "0|1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+    setMemoryLimit(MF_MAX_DEVICEMEM);
+
+    TEST_ASSERT_EQUAL_STRING("5,I2C queue does not fit in Memory;", cmdMessenger.last().c_str());
+    device.set(1, (char *)"5");
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_text_protocol);
+    RUN_TEST(test_text_is_truncated_to_the_wire_buffer);
+    RUN_TEST(test_address_range);
+    RUN_TEST(test_invalid_address_list);
+    RUN_TEST(test_retry_and_diagnostics);
+    RUN_TEST(test_queue);
+    RUN_TEST(test_queue_does_not_fit);
+    return UNITY_END();
+}
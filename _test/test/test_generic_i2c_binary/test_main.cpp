@@ -0,0 +1,218 @@
+#include <unity.h>
+#include "MFCustomDevice.h"
+#include "MFEEPROM.h"
+#include "Wire.h"
+#include "allocateMem.h"
+#include "commandmessenger.h"
+
+#define ADR_PINS   0
+#define ADR_TYPE   20
+#define ADR_CONFIG 60
+
+// the frames below were calculated independently of the device, see crc8()
+static const uint8_t frameText[]     = {0x05, 0x00, 0x03, 'a', 'b', 'c', 0xE8};
+static const uint8_t frameInt16[]    = {0x05, 0x20, 0x02, 0xD2, 0x04, 0x79};
+static const uint8_t frameNegative[] = {0x05, 0x20, 0x02, 0xFE, 0xFF, 0xC4};
+static const uint8_t frameInt32[]    = {0x05, 0x40, 0x04, 0xA0, 0x86, 0x01, 0x00, 0xCF};
+static const uint8_t frameMin32[]    = {0x05, 0x40, 0x04, 0x00, 0x00, 0x00, 0x80, 0xDA};
+static const uint8_t frameFixed[]    = {0x05, 0x60, 0x05, 0x39, 0x30, 0x00, 0x00, 0x02, 0xBC};
+static const uint8_t frameLeading0[] = {0x05, 0x00, 0x03, '0', '0', '7', 0x2A};
+static const uint8_t frameOverflow[] = {0x05, 0x00, 0x0A, '2', '1', '4', '7', '4', '8', '3', '6', '4', '8', 0xAC};
+
+static void writeConfig(const char *config)
+{
+    MFeeprom.write_block(ADR_PINS, "0x20.", 5);
+    MFeeprom.write_block(ADR_TYPE, "MOBIFLIGHT_GENERICI2C.", 22);
+    MFeeprom.write_block(ADR_CONFIG, config, strlen(config));
+}
+
+// reference CRC-8, polynom 0x07, init 0x00, no final XOR
+static uint8_t crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static void assertFrame(const uint8_t *expected, uint8_t length, uint8_t transaction)
+{
+    TEST_ASSERT_EQUAL_HEX8(0x20, Wire.transaction(transaction).address);
+    TEST_ASSERT_EQUAL(length, Wire.transaction(transaction).length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, Wire.transaction(transaction).data, length);
+    TEST_ASSERT_FALSE(Wire.transaction(transaction).overflow);
+}
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    MFeeprom.reset();
+    ClearMemory();
+    cmdMessenger.clear();
+    Wire.reset();
+}
+
+void tearDown(void)
+{
+}
+
+// check values of CRC-8/SMBUS, the frames must have the same CRC
+void test_crc8_reference(void)
+{
+    TEST_ASSERT_EQUAL_HEX8(0xF4, crc8((const uint8_t *)"123456789", 9));
+    TEST_ASSERT_EQUAL_HEX8(0x00, crc8(NULL, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x07, crc8((const uint8_t *)"\x01", 1));
+    TEST_ASSERT_EQUAL_HEX8(0xF3, crc8((const uint8_t *)"\xFF", 1));
+    TEST_ASSERT_EQUAL_HEX8(frameInt16[5], crc8(frameInt16, 5));
+    // without a final XOR the CRC over the frame including the CRC is 0
+    TEST_ASSERT_EQUAL_HEX8(0x00, crc8(frameFixed, sizeof(frameFixed)));
+}
+
+void test_payload_types(void)
+{
+    writeConfig("1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(5, (char *)"abc");
+    device.set(5, (char *)"1234");
+    device.set(5, (char *)"-2");
+    device.set(5, (char *)"100000");
+    device.set(5, (char *)"-2147483648");
+    device.set(5, (char *)"123.45");
+
+    TEST_ASSERT_EQUAL(6, Wire.transactionCount());
+    assertFrame(frameText, sizeof(frameText), 0);
+    assertFrame(frameInt16, sizeof(frameInt16), 1);
+    assertFrame(frameNegative, sizeof(frameNegative), 2);
+    assertFrame(frameInt32, sizeof(frameInt32), 3);
+    assertFrame(frameMin32, sizeof(frameMin32), 4);
+    assertFrame(frameFixed, sizeof(frameFixed), 5);
+}
+
+// leading zeros and numbers out of the int32 range are kept as text
+void test_numbers_sent_as_text(void)
+{
+    writeConfig("1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(5, (char *)"007");
+    device.set(5, (char *)"2147483648");
+
+    TEST_ASSERT_EQUAL(2, Wire.transactionCount());
+    assertFrame(frameLeading0, sizeof(frameLeading0), 0);
+    assertFrame(frameOverflow, sizeof(frameOverflow), 1);
+}
+
+/* **********************************************************************************
+    60 characters: 28 + 28 + 4 bytes of payload, the first two chunks fill the
+    transmit buffer of 32 bytes exactly and have the "more" bit set.
+********************************************************************************** */
+void test_chunks_at_the_wire_buffer(void)
+{
+    char text[61];
+    for (uint8_t i = 0; i < 60; i++)
+        text[i] = 'A' + i % 26;
+    text[60] = 0x00;
+
+    writeConfig("1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+    device.set(7, text);
+
+    const uint8_t headers[3][3] = {{0x07, 0x10, 28}, {0x07, 0x11, 28}, {0x07, 0x02, 4}};
+    const uint8_t crcs[3]       = {0x25, 0xEF, 0x2F};
+    TEST_ASSERT_EQUAL(3, Wire.transactionCount());
+    for (uint8_t i = 0; i < 3; i++) {
+        const TwoWire::Transaction &transaction = Wire.transaction(i);
+        TEST_ASSERT_EQUAL(headers[i][2] + 4, transaction.length);
+        TEST_ASSERT_LESS_OR_EQUAL(BUFFER_LENGTH, transaction.length);
+        TEST_ASSERT_FALSE(transaction.overflow);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(headers[i], transaction.data, 3);
+        TEST_ASSERT_EQUAL_MEMORY(&text[i * 28], &transaction.data[3], headers[i][2]);
+        TEST_ASSERT_EQUAL_HEX8(crcs[i], transaction.data[transaction.length - 1]);
+        TEST_ASSERT_EQUAL_HEX8(crc8(transaction.data, transaction.length - 1), crcs[i]);
+    }
+}
+
+// at most 16 chunks, the rest of the text is dropped
+void test_chunk_limit(void)
+{
+    char text[16 * 28 + 11];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = 0x00;
+
+    writeConfig("1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+    device.set(7, text);
+
+    TEST_ASSERT_EQUAL(16, Wire.transactionCount());
+    for (uint8_t i = 0; i < 16; i++) {
+        const TwoWire::Transaction &transaction = Wire.transaction(i);
+        TEST_ASSERT_EQUAL(BUFFER_LENGTH, transaction.length);
+        TEST_ASSERT_EQUAL_HEX8((i < 15 ? 0x10 : 0x00) | i, transaction.data[1]);
+        TEST_ASSERT_EQUAL_HEX8(0x00, crc8(transaction.data, transaction.length));
+    }
+}
+
+// a NACK on one chunk stops the text for this slave
+void test_chunks_stop_after_a_failure(void)
+{
+    char text[61];
+    memset(text, 'x', 60);
+    text[60] = 0x00;
+
+    writeConfig("1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+    Wire.setResult(0x20, 2);
+    device.set(7, text);
+
+    TEST_ASSERT_EQUAL(1, Wire.transactionCount());
+}
+
+/* **********************************************************************************
+    The queue packs as many frames into one transmission as fit into the transmit
+    buffer: five int16 frames of 6 bytes, the sixth one goes into a second
+    transmission. The first one takes 0.7ms at 400kHz, so the second one
+    starts within the time budget of update().
+********************************************************************************** */
+void test_queue_packs_frames(void)
+{
+    writeConfig("1|1.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    char value[2] = "0";
+    for (uint8_t i = 1; i <= 6; i++) {
+        value[0] = '0' + i;
+        device.set(i, value);
+    }
+    TEST_ASSERT_EQUAL(0, Wire.transactionCount());
+
+    device.update();
+    TEST_ASSERT_EQUAL(2, Wire.transactionCount());
+    TEST_ASSERT_EQUAL(30, Wire.transaction(0).length);
+    for (uint8_t i = 0; i < 5; i++) {
+        const uint8_t *frame = &Wire.transaction(0).data[i * 6];
+        TEST_ASSERT_EQUAL(i + 1, frame[0]);
+        TEST_ASSERT_EQUAL_HEX8(0x20, frame[1]);
+        TEST_ASSERT_EQUAL(2, frame[2]);
+        TEST_ASSERT_EQUAL(i + 1, frame[3] | (frame[4] << 8));
+        TEST_ASSERT_EQUAL_HEX8(crc8(frame, 5), frame[5]);
+    }
+    TEST_ASSERT_EQUAL(6, Wire.transaction(1).length);
+    TEST_ASSERT_EQUAL(6, Wire.transaction(1).data[0]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc8_reference);
+    RUN_TEST(test_payload_types);
+    RUN_TEST(test_numbers_sent_as_text);
+    RUN_TEST(test_chunks_at_the_wire_buffer);
+    RUN_TEST(test_chunk_limit);
+    RUN_TEST(test_chunks_stop_after_a_failure);
+    RUN_TEST(test_queue_packs_frames);
+    return UNITY_END();
+}
@@ -0,0 +1,70 @@
+#include <unity.h>
+#include "MFCustomDevice.h"
+#include "MFEEPROM.h"
+#include "allocateMem.h"
+#include "commandmessenger.h"
+
+#define ADR_PINS   0
+#define ADR_TYPE   20
+#define ADR_CONFIG 40
+
+MFCustomDevice *device;
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    MFeeprom.reset();
+    ClearMemory();
+    cmdMessenger.clear();
+    MFeeprom.write_block(ADR_PINS, "52|51|53|8|9.", 13);
+    MFeeprom.write_block(ADR_TYPE, "MOBIFLIGHT_GNC255.", 18);
+    device = new MFCustomDevice(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+}
+
+void tearDown(void)
+{
+    delete device;
+}
+
+// "Frames sent" of the Force Refresh report
+static uint32_t framesSent()
+{
+    device->set(MESSAGEID_FORCE_REFRESH, (char *)"1");
+    const std::string &report = cmdMessenger.last();
+    size_t             pos    = report.find("Frames sent,");
+    TEST_ASSERT_TRUE(pos != std::string::npos);
+    return strtoul(report.c_str() + pos + strlen("Frames sent,"), NULL, 10);
+}
+
+void test_created_from_eeprom(void)
+{
+    TEST_ASSERT_EQUAL(0, cmdMessenger.count());
+    // the start screen
+    TEST_ASSERT_EQUAL(1, framesSent());
+}
+
+// without MF_CUSTOMDEVICE_HAS_UPDATE each new value is transferred by set(), a repeat is dropped before
+void test_each_change_is_transferred(void)
+{
+    device->set(1, (char *)"118.000");
+    device->set(1, (char *)"118.000");
+    device->set(1, (char *)"118.050");
+    TEST_ASSERT_EQUAL(1, device->getDroppedMessages());
+    TEST_ASSERT_EQUAL(3, framesSent());
+}
+
+void test_unknown_messageID_is_ignored(void)
+{
+    device->set(0, (char *)"1");
+    device->set(42, (char *)"1");
+    TEST_ASSERT_EQUAL(1, framesSent());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_created_from_eeprom);
+    RUN_TEST(test_each_change_is_transferred);
+    RUN_TEST(test_unknown_messageID_is_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#include <unity.h>
+#include "HT1621.h"
+
+#define PIN_CS   2
+#define PIN_WR   3
+#define PIN_DATA 4
+
+HT1621 ht(PIN_CS, PIN_WR, PIN_DATA);
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    ht.begin();
+    ArduinoMock::clearLog();
+}
+
+void tearDown(void)
+{
+}
+
+// DATA at each rising edge of WR while CS is low, from the pin log
+static uint8_t sampleBits(uint8_t *bits, uint8_t size)
+{
+    uint8_t cs = HIGH, data = HIGH, count = 0;
+
+    for (uint32_t i = 0; i < ArduinoMock::eventCount(); i++) {
+        const ArduinoMock::PinEvent &event = ArduinoMock::events()[i];
+        if (event.pin == PIN_CS)
+            cs = event.value;
+        else if (event.pin == PIN_DATA)
+            data = event.value;
+        else if (event.pin == PIN_WR && event.value == HIGH && cs == LOW && count < size)
+            bits[count++] = data;
+    }
+    return count;
+}
+
+void test_begin_sets_the_pins(void)
+{
+    TEST_ASSERT_EQUAL(OUTPUT, ArduinoMock::pinModeOf(PIN_CS));
+    TEST_ASSERT_EQUAL(OUTPUT, ArduinoMock::pinModeOf(PIN_WR));
+    TEST_ASSERT_EQUAL(OUTPUT, ArduinoMock::pinModeOf(PIN_DATA));
+    TEST_ASSERT_EQUAL(HIGH, ArduinoMock::pinValue(PIN_CS));
+    TEST_ASSERT_EQUAL(HIGH, ArduinoMock::pinValue(PIN_WR));
+}
+
+// 3 bit mode and 6 bit address MSB first, then the data LSB first
+void test_write_bit_order(void)
+{
+    const uint8_t expected[13] = {1, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1};
+    uint8_t       bits[20];
+
+    ht.write(5, 0x0A);
+
+    TEST_ASSERT_EQUAL(13, sampleBits(bits, sizeof(bits)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, bits, 13);
+    TEST_ASSERT_EQUAL(HIGH, ArduinoMock::pinValue(PIN_CS));
+}
+
+// the simulated time of a frame must match the bus time of the statistics and the table in HT1621.h
+void test_bus_time_per_profile(void)
+{
+    const HT1621::TimingProfiles profiles[3] = {HT1621::TIMING_LEGACY, HT1621::TIMING_3V, HT1621::TIMING_5V};
+    const uint32_t               usPerWrite[3] = {1020, 136, 68};
+
+    for (uint8_t i = 0; i < 3; i++) {
+        ht.setTiming(profiles[i]);
+        ht.resetStatistics();
+        uint64_t start = ArduinoMock::now();
+        ht.write(0, 0xA5, 8);
+        TEST_ASSERT_EQUAL(usPerWrite[i], (ArduinoMock::now() - start) / 1000);
+        TEST_ASSERT_EQUAL(usPerWrite[i], ht.getBusTime());
+        TEST_ASSERT_EQUAL(17, ht.getBitsSent());
+        TEST_ASSERT_EQUAL(1, ht.getFramesSent());
+    }
+}
+
+void test_flush_sends_only_dirty_addresses(void)
+{
+    ht.bufferedWrite(4, 0x3);
+    ht.bufferedWrite(4, 0x3);
+    ht.flush();
+    TEST_ASSERT_EQUAL(1, ht.getFramesSent());
+    TEST_ASSERT_EQUAL(13, ht.getBitsSent());
+
+    ht.flush();
+    TEST_ASSERT_EQUAL(1, ht.getFramesSent());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_sets_the_pins);
+    RUN_TEST(test_write_bit_order);
+    RUN_TEST(test_bus_time_per_profile);
+    RUN_TEST(test_flush_sends_only_dirty_addresses);
+    return UNITY_END();
+}
@@ -0,0 +1,156 @@
+#include <unity.h>
+#include <vector>
+#include "HT1621.h"
+#include "HT1621Decoder.h"
+
+#define PIN_CS   2
+#define PIN_WR   3
+#define PIN_DATA 4
+
+HT1621 ht(PIN_CS, PIN_WR, PIN_DATA);
+
+// dirty addresses of each case: single nibbles, runs, gaps up to FLUSH_MAX_GAP and above, the wrap at 31 and all
+static const uint32_t cases[] = {0x00000001, 0x00000F0F, 0x80000001, 0x0000A5A5, 0x12480000, 0x00F00C03, 0xFFFFFFFF};
+#define CASES (sizeof(cases) / sizeof(cases[0]))
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void start(bool async)
+{
+    ArduinoMock::reset();
+    ht.begin();
+    ht.setTiming(HT1621::TIMING_5V);
+    ht.setAsync(async);
+    ht.resetStatistics();
+    ArduinoMock::clearLog();
+}
+
+// no address is written with 0, so each one of the mask is dirty
+static void stage(uint32_t mask)
+{
+    for (uint8_t i = 0; i < HT1621::MAX_ADDR; i++) {
+        if (mask & (1ul << i))
+            ht.bufferedWrite(i, ((i * 5 + 3) & 0x0F) | 1);
+    }
+}
+
+// the pin changes since the last clearLog(), the time relative to the first one
+static std::vector<ArduinoMock::PinEvent> waveform(void)
+{
+    std::vector<ArduinoMock::PinEvent> events(ArduinoMock::events(), ArduinoMock::events() + ArduinoMock::eventCount());
+    for (size_t i = 1; i < events.size(); i++)
+        events[i].timeNs -= events[0].timeNs;
+    if (events.size())
+        events[0].timeNs = 0;
+    return events;
+}
+
+static std::vector<ArduinoMock::PinEvent> sendSync(uint32_t mask)
+{
+    start(false);
+    stage(mask);
+    ht.flush();
+    return waveform();
+}
+
+static void stageAsync(uint32_t mask)
+{
+    start(true);
+    stage(mask);
+    ht.flush();
+    TEST_ASSERT_EQUAL(0, ArduinoMock::eventCount());
+}
+
+// update() until nothing is left, gapNs simulates the rest of the loop between two calls
+static std::vector<ArduinoMock::PinEvent> runUpdates(uint8_t maxBits, uint32_t gapNs, uint16_t &calls)
+{
+    calls = 0;
+    bool pending;
+    do {
+        calls++;
+        pending = ht.update(maxBits);
+        ArduinoMock::advance(gapNs);
+    } while (pending);
+    return waveform();
+}
+
+static void assertSameWaveform(const std::vector<ArduinoMock::PinEvent> &sync, const std::vector<ArduinoMock::PinEvent> &async, bool compareTime)
+{
+    TEST_ASSERT_EQUAL(sync.size(), async.size());
+    for (size_t i = 0; i < sync.size(); i++) {
+        TEST_ASSERT_EQUAL(sync[i].pin, async[i].pin);
+        TEST_ASSERT_EQUAL(sync[i].value, async[i].value);
+        if (compareTime)
+            TEST_ASSERT_EQUAL(sync[i].timeNs, async[i].timeNs);
+    }
+}
+
+// without time between the calls the edges of both paths are at the same time as well
+void test_async_waveform_equals_flush(void)
+{
+    for (uint8_t i = 0; i < CASES; i++) {
+        std::vector<ArduinoMock::PinEvent> sync = sendSync(cases[i]);
+        uint32_t                           bits   = ht.getBitsSent();
+        uint16_t                           frames = ht.getFramesSent();
+
+        uint16_t calls;
+        stageAsync(cases[i]);
+        std::vector<ArduinoMock::PinEvent> async = runUpdates(HT1621_ASYNC_BITS_PER_UPDATE, 0, calls);
+
+        assertSameWaveform(sync, async, true);
+        TEST_ASSERT_EQUAL(bits, ht.getBitsSent());
+        TEST_ASSERT_EQUAL(frames, ht.getFramesSent());
+        // a call continues with the next frame, so only the last one sends less bits
+        TEST_ASSERT_EQUAL((bits + HT1621_ASYNC_BITS_PER_UPDATE - 1) / HT1621_ASYNC_BITS_PER_UPDATE, calls);
+    }
+}
+
+// other split sizes, also within the mode, the address and a nibble
+void test_async_split_sizes(void)
+{
+    const uint8_t sizes[] = {1, 2, 3, 5, 7, 9, 13, 64, 255};
+
+    for (uint8_t i = 0; i < CASES; i++) {
+        std::vector<ArduinoMock::PinEvent> sync = sendSync(cases[i]);
+        for (uint8_t j = 0; j < sizeof(sizes); j++) {
+            uint16_t calls;
+            stageAsync(cases[i]);
+            assertSameWaveform(sync, runUpdates(sizes[j], 0, calls), true);
+        }
+    }
+}
+
+// with the loop between the calls CS stays low longer, the clocks and the RAM are the same
+void test_async_with_time_between_updates(void)
+{
+    for (uint8_t i = 0; i < CASES; i++) {
+        std::vector<ArduinoMock::PinEvent> sync = sendSync(cases[i]);
+
+        stageAsync(cases[i]);
+        HT1621Decoder decoder(PIN_CS, PIN_WR, PIN_DATA, HT1621Decoder::VDD_5V);
+        uint16_t      calls;
+        assertSameWaveform(sync, runUpdates(HT1621_ASYNC_BITS_PER_UPDATE, 1000000, calls), false);
+
+        for (uint8_t address = 0; address < HT1621::MAX_ADDR; address++)
+            TEST_ASSERT_EQUAL_HEX8(ht.read(address), decoder.ram(address));
+        TEST_ASSERT_EQUAL(0, decoder.getIncompleteFrames());
+        TEST_ASSERT_EQUAL(0, decoder.getViolations(HT1621Decoder::WR_LOW_WIDTH));
+        TEST_ASSERT_EQUAL(0, decoder.getViolations(HT1621Decoder::DATA_SETUP));
+        TEST_ASSERT_EQUAL(0, decoder.getViolations(HT1621Decoder::DATA_HOLD));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_async_waveform_equals_flush);
+    RUN_TEST(test_async_split_sizes);
+    RUN_TEST(test_async_with_time_between_updates);
+    return UNITY_END();
+}
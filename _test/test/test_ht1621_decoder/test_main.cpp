@@ -0,0 +1,218 @@
+#include <unity.h>
+#include "HT1621.h"
+#include "HT1621Decoder.h"
+
+#define PIN_CS   2
+#define PIN_WR   3
+#define PIN_DATA 4
+
+HT1621         ht(PIN_CS, PIN_WR, PIN_DATA);
+HT1621Decoder *decoder;
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    decoder = new HT1621Decoder(PIN_CS, PIN_WR, PIN_DATA);
+    ht.begin();
+    ht.setTiming(HT1621::TIMING_LEGACY);
+}
+
+void tearDown(void)
+{
+    delete decoder;
+}
+
+// one clock driven by the test instead of the driver
+static void clockBit(uint8_t bit)
+{
+    digitalWrite(PIN_WR, LOW);
+    digitalWrite(PIN_DATA, bit);
+    delayMicroseconds(10);
+    digitalWrite(PIN_WR, HIGH);
+    delayMicroseconds(10);
+}
+
+static void clockBits(uint8_t data, uint8_t cnt)
+{
+    for (uint8_t i = cnt; i > 0; i--)
+        clockBit((data >> (i - 1)) & 1);
+}
+
+static void assertRamMatchesShadow(void)
+{
+    for (uint8_t i = 0; i < HT1621::MAX_ADDR; i++)
+        TEST_ASSERT_EQUAL_HEX8(ht.read(i), decoder->ram(i));
+}
+
+void test_commands(void)
+{
+    ht.sendCommand(HT1621::RC256K);
+    ht.sendCommand(HT1621::BIAS_THIRD_4_COM);
+    ht.sendCommand(HT1621::SYS_EN);
+    ht.sendCommand(HT1621::LCD_ON);
+
+    TEST_ASSERT_EQUAL(4, decoder->getCommandFrames());
+    TEST_ASSERT_EQUAL_HEX8(HT1621::RC256K, decoder->oscillator());
+    TEST_ASSERT_EQUAL_HEX8(HT1621::BIAS_THIRD_4_COM, decoder->bias());
+    TEST_ASSERT_TRUE(decoder->systemEnabled());
+    TEST_ASSERT_TRUE(decoder->lcdOn());
+
+    // successive commands within one frame, 9 bits each
+    ht.sendCommand(HT1621::LCD_OFF, true, false);
+    ht.sendCommand(HT1621::TONE_ON, false, true);
+    TEST_ASSERT_EQUAL(5, decoder->getCommandFrames());
+    TEST_ASSERT_FALSE(decoder->lcdOn());
+    TEST_ASSERT_TRUE(decoder->toneOn());
+    TEST_ASSERT_EQUAL(0, decoder->getIncompleteFrames());
+}
+
+// nibbles are written LSB first, the address increments and wraps at 32
+void test_write_frames(void)
+{
+    uint8_t array[3] = {0x1, 0x3, 0x5};
+
+    ht.write(5, 0x0A);
+    TEST_ASSERT_EQUAL_HEX8(0x0A, decoder->ram(5));
+
+    ht.write(30, 0x1234, 16);
+    TEST_ASSERT_EQUAL_HEX8(0x4, decoder->ram(30));
+    TEST_ASSERT_EQUAL_HEX8(0x3, decoder->ram(31));
+    TEST_ASSERT_EQUAL_HEX8(0x2, decoder->ram(0));
+    TEST_ASSERT_EQUAL_HEX8(0x1, decoder->ram(1));
+
+    ht.writeArray(10, array, 3);
+    TEST_ASSERT_EQUAL_HEX8(0x31, decoder->ramByte(10));
+    TEST_ASSERT_EQUAL_HEX8(0x5, decoder->ram(12));
+
+    TEST_ASSERT_EQUAL(3, decoder->getWriteFrames());
+    TEST_ASSERT_EQUAL(0, decoder->getIncompleteFrames());
+    assertRamMatchesShadow();
+}
+
+// the frames of flush() with gaps and runs must leave the RAM like the shadow RAM
+void test_flush_matches_the_shadow_ram(void)
+{
+    srand(1621);
+    for (uint8_t round = 0; round < 50; round++) {
+        uint8_t changes = rand() % 8;
+        for (uint8_t i = 0; i < changes; i++)
+            ht.bufferedWrite(rand() % HT1621::MAX_ADDR, rand() & 0x0F);
+        ht.flush();
+        assertRamMatchesShadow();
+    }
+    TEST_ASSERT_EQUAL(0, decoder->getIncompleteFrames());
+}
+
+// CS low time against the calculated bus time, the pin toggling takes no time here
+void test_bus_time(void)
+{
+    ht.resetStatistics();
+    decoder->resetStatistics();
+
+    ht.write(0, 0xA5, 8);
+    TEST_ASSERT_EQUAL(17, decoder->getBitsReceived());
+    TEST_ASSERT_EQUAL(1020000, decoder->getBusTimeNs());
+    TEST_ASSERT_EQUAL(ht.getBusTime() * 1000ull, decoder->getBusTimeNs());
+
+    // with 100ns per digitalWrite() the frame takes 3 writes per bit and the CS edges longer
+    ArduinoMock::setWriteCost(100);
+    decoder->resetStatistics();
+    ht.write(0, 0x5A, 8);
+    TEST_ASSERT_EQUAL(1020000 + (17 * 3 + 1) * 100, decoder->getBusTimeNs());
+}
+
+void test_timing_violations(void)
+{
+    HT1621Decoder decoder3V(PIN_CS, PIN_WR, PIN_DATA, HT1621Decoder::VDD_3V);
+
+    ht.setTiming(HT1621::TIMING_3V);
+    ht.write(0, 0xA5, 8);
+    TEST_ASSERT_EQUAL(0, decoder3V.getViolations());
+    TEST_ASSERT_EQUAL(0, decoder->getViolations());
+
+    // 2us is enough at 5V, not at 3V, the high time after the last bit is not within the frame
+    ht.setTiming(HT1621::TIMING_5V);
+    ht.write(0, 0x5A, 8);
+    TEST_ASSERT_EQUAL(17, decoder3V.getViolations(HT1621Decoder::WR_LOW_WIDTH));
+    TEST_ASSERT_EQUAL(16, decoder3V.getViolations(HT1621Decoder::WR_HIGH_WIDTH));
+    TEST_ASSERT_EQUAL(0, decoder3V.getViolations(HT1621Decoder::DATA_SETUP));
+    TEST_ASSERT_EQUAL(0, decoder3V.getViolations(HT1621Decoder::DATA_HOLD));
+    TEST_ASSERT_EQUAL(0, decoder->getViolations());
+    TEST_ASSERT_EQUAL_HEX8(0x5A, decoder3V.ramByte(0));
+}
+
+void test_data_setup_and_hold(void)
+{
+    digitalWrite(PIN_CS, LOW);
+    digitalWrite(PIN_WR, LOW);
+    delayMicroseconds(10);
+    digitalWrite(PIN_DATA, LOW);
+    ArduinoMock::advance(HT1621::MIN_DATA_SETUP_NS - 1);
+    digitalWrite(PIN_WR, HIGH);
+    ArduinoMock::advance(HT1621::MIN_DATA_HOLD_NS - 1);
+    digitalWrite(PIN_DATA, HIGH);
+    digitalWrite(PIN_CS, HIGH);
+
+    TEST_ASSERT_EQUAL(1, decoder->getViolations(HT1621Decoder::DATA_SETUP));
+    TEST_ASSERT_EQUAL(1, decoder->getViolations(HT1621Decoder::DATA_HOLD));
+    TEST_ASSERT_EQUAL(1, decoder->getIncompleteFrames());
+}
+
+void test_incomplete_frames(void)
+{
+    // address cut off
+    digitalWrite(PIN_CS, LOW);
+    clockBits(0b101, 3);
+    clockBits(0b0001, 4);
+    digitalWrite(PIN_CS, HIGH);
+    // nibble cut off
+    digitalWrite(PIN_CS, LOW);
+    clockBits(0b101, 3);
+    clockBits(0b000001, 6);
+    clockBits(0b11, 2);
+    digitalWrite(PIN_CS, HIGH);
+
+    TEST_ASSERT_EQUAL(2, decoder->getWriteFrames());
+    TEST_ASSERT_EQUAL(2, decoder->getIncompleteFrames());
+    TEST_ASSERT_EQUAL(0, decoder->ram(1));
+}
+
+// the decoder drives DATA with the RAM, D0 first
+void test_read_frame(void)
+{
+    uint8_t bits[4];
+
+    ht.write(7, 0x9);
+    digitalWrite(PIN_CS, LOW);
+    clockBits(0b110, 3);
+    clockBits(7, 6);
+    pinMode(PIN_DATA, INPUT);
+    for (uint8_t i = 0; i < 4; i++) {
+        digitalWrite(PIN_WR, LOW);
+        delayMicroseconds(10);
+        bits[i] = digitalRead(PIN_DATA);
+        digitalWrite(PIN_WR, HIGH);
+        delayMicroseconds(10);
+    }
+    pinMode(PIN_DATA, OUTPUT);
+    digitalWrite(PIN_CS, HIGH);
+
+    const uint8_t expected[4] = {1, 0, 0, 1};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, bits, 4);
+    TEST_ASSERT_EQUAL(1, decoder->getReadFrames());
+    TEST_ASSERT_EQUAL(0, decoder->getIncompleteFrames());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_commands);
+    RUN_TEST(test_write_frames);
+    RUN_TEST(test_flush_matches_the_shadow_ram);
+    RUN_TEST(test_bus_time);
+    RUN_TEST(test_timing_violations);
+    RUN_TEST(test_data_setup_and_hold);
+    RUN_TEST(test_incomplete_frames);
+    RUN_TEST(test_read_frame);
+    return UNITY_END();
+}
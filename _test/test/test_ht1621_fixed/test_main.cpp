@@ -0,0 +1,128 @@
+#include <unity.h>
+#include <vector>
+#include "HT1621.h"
+#include "HT1621Fixed.h"
+#include "HT1621Decoder.h"
+
+#define PIN_CS   2
+#define PIN_WR   3
+#define PIN_DATA 4
+
+HT1621                                 runtime(PIN_CS, PIN_WR, PIN_DATA);
+HT1621Fixed<PIN_CS, PIN_WR, PIN_DATA> fixed;
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void start(HT1621 &ht)
+{
+    ArduinoMock::reset();
+    ht.begin();
+    ht.setTiming(HT1621::TIMING_5V);
+    ht.setAsync(false);
+    ht.resetStatistics();
+    ArduinoMock::clearLog();
+}
+
+// the pin changes since the last clearLog(), the time relative to the first one
+static std::vector<ArduinoMock::PinEvent> waveform(void)
+{
+    std::vector<ArduinoMock::PinEvent> events(ArduinoMock::events(), ArduinoMock::events() + ArduinoMock::eventCount());
+    for (size_t i = 1; i < events.size(); i++)
+        events[i].timeNs -= events[0].timeNs;
+    if (events.size())
+        events[0].timeNs = 0;
+    return events;
+}
+
+static void assertSameWaveform(const std::vector<ArduinoMock::PinEvent> &expected, const std::vector<ArduinoMock::PinEvent> &actual)
+{
+    TEST_ASSERT_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL(expected[i].pin, actual[i].pin);
+        TEST_ASSERT_EQUAL(expected[i].value, actual[i].value);
+        TEST_ASSERT_EQUAL(expected[i].timeNs, actual[i].timeNs);
+    }
+}
+
+// the same calls on both versions
+static void sequence(HT1621 &ht)
+{
+    uint8_t array[4] = {0x1, 0x3, 0x5, 0x7};
+
+    ht.sendCommand(HT1621::SYS_EN);
+    ht.sendCommand(HT1621::LCD_OFF, true, false);
+    ht.sendCommand(HT1621::LCD_ON, false, true);
+    ht.write(5, 0x0A);
+    ht.write(30, 0x1234, 16);
+    ht.writeArray(10, array, 4);
+    for (uint8_t i = 0; i < HT1621::MAX_ADDR; i += 3)
+        ht.bufferedWrite(i, (i * 7) & 0x0F);
+    ht.flush();
+}
+
+void test_fixed_waveform_equals_runtime(void)
+{
+    start(runtime);
+    sequence(runtime);
+    std::vector<ArduinoMock::PinEvent> expected = waveform();
+    uint32_t                           bits     = runtime.getBitsSent();
+    uint32_t                           busTime  = runtime.getBusTime();
+
+    start(fixed);
+    sequence(fixed);
+    assertSameWaveform(expected, waveform());
+    TEST_ASSERT_EQUAL(bits, fixed.getBitsSent());
+    TEST_ASSERT_EQUAL(busTime, fixed.getBusTime());
+}
+
+void test_fixed_ram(void)
+{
+    start(fixed);
+    HT1621Decoder decoder(PIN_CS, PIN_WR, PIN_DATA, HT1621Decoder::VDD_5V);
+    sequence(fixed);
+
+    for (uint8_t address = 0; address < HT1621::MAX_ADDR; address++)
+        TEST_ASSERT_EQUAL_HEX8(fixed.read(address), decoder.ram(address));
+    TEST_ASSERT_TRUE(decoder.systemEnabled());
+    TEST_ASSERT_TRUE(decoder.lcdOn());
+    TEST_ASSERT_EQUAL(0, decoder.getIncompleteFrames());
+    TEST_ASSERT_EQUAL(0, decoder.getViolations());
+}
+
+#if defined(HT1621_ASYNC)
+// update() sends the frames of the queue through the same function
+void test_fixed_async_update(void)
+{
+    start(runtime);
+    for (uint8_t i = 0; i < HT1621::MAX_ADDR; i++)
+        runtime.bufferedWrite(i, i & 0x0F);
+    runtime.flush();
+    std::vector<ArduinoMock::PinEvent> expected = waveform();
+
+    start(fixed);
+    fixed.setAsync(true);
+    for (uint8_t i = 0; i < HT1621::MAX_ADDR; i++)
+        fixed.bufferedWrite(i, i & 0x0F);
+    fixed.flush();
+    while (fixed.update(HT1621_ASYNC_BITS_PER_UPDATE))
+        ;
+    assertSameWaveform(expected, waveform());
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_waveform_equals_runtime);
+    RUN_TEST(test_fixed_ram);
+#if defined(HT1621_ASYNC)
+    RUN_TEST(test_fixed_async_update);
+#endif
+    return UNITY_END();
+}
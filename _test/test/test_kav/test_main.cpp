@@ -0,0 +1,110 @@
+#include <unity.h>
+#include "MFCustomDevice.h"
+#include "MFEEPROM.h"
+#include "allocateMem.h"
+#include "commandmessenger.h"
+
+// EEPROM addresses of the pins, the type and the config like the firmware stores them
+#define ADR_PINS   0
+#define ADR_TYPE   20
+#define ADR_CONFIG 40
+
+static void writeConfig(const char *pins, const char *type, const char *config)
+{
+    MFeeprom.write_block(ADR_PINS, pins, strlen(pins));
+    MFeeprom.write_block(ADR_TYPE, type, strlen(type));
+    MFeeprom.write_block(ADR_CONFIG, config, strlen(config));
+}
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    MFeeprom.reset();
+    ClearMemory();
+    setMemoryLimit(MF_MAX_DEVICEMEM);
+    cmdMessenger.clear();
+}
+
+void tearDown(void)
+{
+}
+
+void test_fcu_from_eeprom(void)
+{
+    writeConfig("4|2|3.", "KAV_FCU.", ".");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    TEST_ASSERT_EQUAL(0, cmdMessenger.count());
+    // CS is taken for the init commands and the clear of the display
+    TEST_ASSERT_EQUAL(OUTPUT, ArduinoMock::pinModeOf(2));
+    TEST_ASSERT_EQUAL(HIGH, ArduinoMock::pinValue(2));
+    TEST_ASSERT_GREATER_THAN(0, ArduinoMock::eventCount());
+
+    ArduinoMock::clearLog();
+    device.set(0, (char *)"250");
+    TEST_ASSERT_GREATER_THAN(0, ArduinoMock::eventCount());
+}
+
+void test_repeated_values_are_dropped(void)
+{
+    writeConfig("4|2|3.", "KAV_FCU.", ".");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(2, (char *)"180");
+    ArduinoMock::clearLog();
+    device.set(2, (char *)"180");
+    TEST_ASSERT_EQUAL(0, ArduinoMock::eventCount());
+    TEST_ASSERT_EQUAL(1, device.getDroppedMessages());
+
+    device.set(-1, (char *)"");
+    device.set(2, (char *)"180");
+    TEST_ASSERT_EQUAL(1, device.getDroppedMessages());
+}
+
+void test_force_refresh_reports_the_statistics(void)
+{
+    writeConfig("4|2|3.", "KAV_FCU.", ".");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    device.set(MESSAGEID_FORCE_REFRESH, (char *)"1");
+    TEST_ASSERT_TRUE(cmdMessenger.contains("Repeated messages dropped,0,Bits sent,"));
+}
+
+void test_unknown_type(void)
+{
+    writeConfig("4|2|3.", "KAV_FMS.", ".");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    TEST_ASSERT_EQUAL_STRING("5,Custom Device is not supported by this firmware version;", cmdMessenger.last().c_str());
+    device.set(0, (char *)"250");
+    TEST_ASSERT_EQUAL(0, ArduinoMock::eventCount());
+}
+
+void test_fcu_does_not_fit(void)
+{
+    setMemoryLimit(sizeof(KAV_A3XX_FCU_LCD) - 1);
+    writeConfig("4|2|3.", "KAV_FCU.", ".");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    TEST_ASSERT_EQUAL_STRING("5,FCU LCD does not fit in Memory;", cmdMessenger.last().c_str());
+}
+
+void test_segment_lcd_config_error(void)
+{
+    writeConfig("4|2|3.", "HT1621_SEGMENT.", "X9.");
+    MFCustomDevice device(ADR_PINS, ADR_TYPE, ADR_CONFIG);
+
+    TEST_ASSERT_TRUE(cmdMessenger.contains("Segment LCD config is not valid"));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fcu_from_eeprom);
+    RUN_TEST(test_repeated_values_are_dropped);
+    RUN_TEST(test_force_refresh_reports_the_statistics);
+    RUN_TEST(test_unknown_type);
+    RUN_TEST(test_fcu_does_not_fit);
+    RUN_TEST(test_segment_lcd_config_error);
+    return UNITY_END();
+}
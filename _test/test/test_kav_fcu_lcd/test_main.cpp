@@ -0,0 +1,190 @@
+#include <unity.h>
+#include <stdio.h>
+#include "KAV_A3XX_FCU_LCD.h"
+#include "HT1621Decoder.h"
+
+#define PIN_CS   2
+#define PIN_CLK  3
+#define PIN_DATA 4
+#define DIGITS   16
+
+// what is on the glass, one byte per digit of the FCU, checked against the decoded RAM of the HT1621
+KAV_A3XX_FCU_LCD fcu(PIN_CS, PIN_CLK, PIN_DATA);
+HT1621Decoder   *decoder;
+uint8_t          glass[DIGITS];
+
+void setUp(void)
+{
+    ArduinoMock::reset();
+    decoder = new HT1621Decoder(PIN_CS, PIN_CLK, PIN_DATA);
+    fcu.begin();
+    // latitude label at digit 4, altitude and LVL/CH labels at digit 15
+    memset(glass, 0, sizeof(glass));
+    glass[4]  = 0x01;
+    glass[15] = 0x03;
+}
+
+void tearDown(void)
+{
+    delete decoder;
+}
+
+static void set(int8_t messageID, const char *value)
+{
+    char buffer[12];
+    strncpy(buffer, value, sizeof(buffer));
+    fcu.set(messageID, buffer);
+}
+
+static void assertGlass(void)
+{
+    uint8_t decoded[DIGITS];
+    for (uint8_t i = 0; i < DIGITS; i++)
+        decoded[i] = decoder->ramByte(i * 2);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(glass, decoded, DIGITS);
+    TEST_ASSERT_EQUAL(0, decoder->getIncompleteFrames());
+    TEST_ASSERT_EQUAL(0, decoder->getViolations());
+}
+
+void test_begin(void)
+{
+    TEST_ASSERT_TRUE(decoder->systemEnabled());
+    TEST_ASSERT_TRUE(decoder->lcdOn());
+    TEST_ASSERT_EQUAL_HEX8(HT1621::BIAS_THIRD_4_COM, decoder->bias());
+    TEST_ASSERT_EQUAL_HEX8(HT1621::RC256K, decoder->oscillator());
+    assertGlass();
+}
+
+void test_speed_and_mach(void)
+{
+    set(0, "250");
+    glass[0]  = 0xBC; // 2
+    glass[1]  = 0xD6; // 5
+    glass[2]  = 0xFA; // 0
+    glass[15] = 0x83; // speed label
+    assertGlass();
+
+    set(1, "78");
+    glass[0]  = 0xFA; // 0
+    glass[1]  = 0x71; // 7 and the decimal point of mach
+    glass[2]  = 0xFE; // 8
+    glass[15] = 0x43; // mach label instead of speed label
+    assertGlass();
+}
+
+void test_heading_and_altitude(void)
+{
+    set(2, "123");
+    glass[3] = 0x60; // 1
+    glass[4] = 0xBD; // 2, the latitude label is kept
+    glass[5] = 0xF4; // 3
+    assertGlass();
+
+    set(3, "35000");
+    glass[6]  = 0xF4;
+    glass[7]  = 0xD6;
+    glass[8]  = 0xFA;
+    glass[9]  = 0xFA;
+    glass[10] = 0xFA;
+    assertGlass();
+
+    set(7, "1");
+    glass[3] = 0x04;
+    glass[4] = 0x05;
+    glass[5] = 0x04;
+    assertGlass();
+}
+
+void test_vertical_and_fpa(void)
+{
+    set(4, "-1500");
+    glass[11] = 0x60; // 1
+    glass[12] = 0xD6; // 5
+    glass[13] = 0xCC; // small 0
+    glass[14] = 0xCD; // small 0 and minus
+    assertGlass();
+
+    set(5, "-25");
+    glass[11] = 0xBC; // 2
+    glass[12] = 0xD7; // 5 and the decimal point
+    glass[13] = 0x00;
+    glass[14] = 0x01; // minus
+    assertGlass();
+}
+
+void test_track_mode_and_clear(void)
+{
+    set(13, "1");
+    glass[6]  = 0x01; // FPA label
+    glass[8]  = 0x01; // track label
+    glass[15] = 0x1B; // track and FPA labels
+    assertGlass();
+
+    set(-1, "");
+    memset(glass, 0, sizeof(glass));
+    assertGlass();
+}
+
+/* **********************************************************************************
+    Bus time of each message from the start screen, the CS low time seen by the
+    decoder must be the bus time calculated by the driver.
+********************************************************************************** */
+void test_bus_time_per_message(void)
+{
+    static const struct {
+        int8_t      messageID;
+        const char *value;
+    } messages[] = {{0, "250"}, {1, "78"}, {2, "123"}, {3, "35000"}, {4, "-1500"}, {5, "-25"}, {6, "1"}, {7, "1"}, {8, "1"}, {9, "1"}, {10, "1"}, {11, "1"}, {12, "1"}, {13, "1"}, {14, "1"}, {15, "1"}, {16, "300"}};
+
+    for (uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+        fcu.clearLCD();
+        fcu.setStartLabels();
+        fcu.refreshLCD();
+        fcu.getHT1621()->resetStatistics();
+        decoder->resetStatistics();
+
+        set(messages[i].messageID, messages[i].value);
+
+        char line[80];
+        snprintf(line, sizeof(line), "messageID %d: %u frames, %lu bits, %llu us", messages[i].messageID, decoder->getFrames(),
+                 (unsigned long)decoder->getBitsReceived(), (unsigned long long)decoder->getBusTimeNs() / 1000);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_EQUAL(fcu.getHT1621()->getFramesSent(), decoder->getFrames());
+        TEST_ASSERT_EQUAL(fcu.getHT1621()->getBitsSent(), decoder->getBitsReceived());
+        TEST_ASSERT_EQUAL(fcu.getHT1621()->getBusTime() * 1000ull, decoder->getBusTimeNs());
+    }
+
+    // 250 knots from the start screen: addresses 0..5 in one frame, the speed label at address 31 in a second one
+    fcu.clearLCD();
+    fcu.setStartLabels();
+    fcu.refreshLCD();
+    decoder->resetStatistics();
+    set(0, "250");
+    TEST_ASSERT_EQUAL(2, decoder->getFrames());
+    TEST_ASSERT_EQUAL(9 + 6 * 4 + 9 + 4, decoder->getBitsReceived());
+    TEST_ASSERT_EQUAL(46 * 60 * 1000, decoder->getBusTimeNs());
+
+    // one digit: one frame of two nibbles
+    decoder->resetStatistics();
+    set(0, "251");
+    TEST_ASSERT_EQUAL(1, decoder->getFrames());
+    TEST_ASSERT_EQUAL(17 * 60 * 1000, decoder->getBusTimeNs());
+
+    // the same value again changes nothing on the glass
+    decoder->resetStatistics();
+    set(0, "251");
+    TEST_ASSERT_EQUAL(0, decoder->getFrames());
+    TEST_ASSERT_EQUAL(0, decoder->getBusTimeNs());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin);
+    RUN_TEST(test_speed_and_mach);
+    RUN_TEST(test_heading_and_altitude);
+    RUN_TEST(test_vertical_and_fpa);
+    RUN_TEST(test_track_mode_and_clear);
+    RUN_TEST(test_bus_time_per_message);
+    return UNITY_END();
+}